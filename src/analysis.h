@@ -134,11 +134,13 @@ namespace Faunus {
                                 if (!g.atomic) // update molecular mass-center
                                     g.cm = Geometry::massCenter(g.begin(), g.end(),
                                             spc.geo.getBoundaryFunc(), -g.begin()->pos);
+                                spc.update(change); // e.g. bounding radius of ghost group
 
                                 expu += exp( -pot->energy(change) ); // widom average
                             }
                         }
                         g.resize(0); // deactive molecule
+                        spc.update(change); // e.g. remove ghost from neighbour lists
                     }
                 }
 
@@ -1158,10 +1160,81 @@ namespace Faunus {
                     name = "virtualvolume";
                     cite = "doi:10.1063/1.472721";
                     getVolume = [&spc](){ return spc.geo.getVolume(); };
-                    scaleVolume = [&spc](double Vnew) { spc.scaleVolume(Vnew); };
+                    scaleVolume = [&spc, &c=c](double Vnew) {
+                        spc.scaleVolume(Vnew);
+                        spc.update(c); // e.g. neighbour lists
+                    };
                 }
         }; //!< Excess pressure using virtual volume move
 
+#ifdef DOCTEST_LIBRARY_INCLUDED
+        TEST_CASE("[Faunus] WidomInsertion and VirtualVolume - neighbour lists")
+        {
+            typedef Space<Geometry::Chameleon, Particle<Charge>> Tspace;
+            typedef Potential::CoulombGalore Tpairpot;
+
+            SaltFixture<Tspace> salt( R"( {"type": "cuboid", "length": 20} )"_json );
+            salt.addSalt(100);
+            salt.addSalt(2); // ghost for Widom insertion
+            auto &spc = salt.spc;
+            spc.groups.back().resize(0);
+            Change all;
+            all.all = true;
+            spc.update(all);
+
+            // analyses must leave the neighbour search in the state of the space
+            json j = R"({"cutoff": 5, "coulomb": {"type": "plain", "epsr": 80, "cutoff": 5}})"_json;
+            Energy::Nonbonded<Tspace, Tpairpot> plain(j, spc);
+            Energy::NonbondedNeighbors<Tspace, Tpairpot> cells(j, spc);
+            Energy::NonbondedNeighbors<Tspace, Tpairpot, Energy::PolicyVerletList<Tspace>> verlet(j, spc);
+            Energy::NonbondedVectorized<Tspace, Tpairpot> simd(j, spc);
+            std::vector<Energy::Energybase*> pots = {&plain, &cells, &verlet, &simd}; // reference first
+
+            auto compare = [&]() {
+                Change change;
+                change.groups.resize(1);
+                change.groups[0].index = 0;
+                for (int i=0; i<int(spc.groups[0].size()); i++) {
+                    change.groups[0].atoms = {i};
+                    for (size_t k=1; k<pots.size(); k++)
+                        CHECK( pots[k]->energy(change) == doctest::Approx(plain.energy(change)) );
+                }
+            }; // single particle energies
+
+            json in = R"({"molecule": "salt", "ninsert": 20, "nstep": 1})"_json;
+            auto random0 = Faunus::random;
+            std::vector<double> excess;
+            for (auto pot : pots) {
+                Faunus::random = random0; // same insertions
+                WidomInsertion<Tspace> widom(in, spc, *pot);
+                widom.sample();
+                CHECK( spc.groups.back().empty() );
+                excess.push_back( json(widom)["widom"][u8::mu+"/kT"]["excess"] );
+            }
+            for (size_t k=1; k<excess.size(); k++)
+                CHECK( excess[k] == doctest::Approx(excess[0]) );
+            compare();
+
+            in = R"({"dV": 10, "nstep": 1})"_json;
+            std::vector<double> pex;
+            for (auto pot : pots) {
+                VirtualVolume virtualvolume(in, spc, *pot);
+                virtualvolume.sample();
+                pex.push_back( json(virtualvolume)["virtualvolume"]["Pex/mM"] );
+            }
+            for (size_t k=1; k<pex.size(); k++)
+                CHECK( pex[k] == doctest::Approx(pex[0]) );
+            compare();
+
+            // the structure-of-arrays mirror follows volume scaling without `Space::update()`
+            double V = spc.geo.getVolume();
+            spc.scaleVolume(1.1*V);
+            CHECK( simd.energy(all) == doctest::Approx(plain.energy(all)) );
+            spc.scaleVolume(V);
+            CHECK( simd.energy(all) == doctest::Approx(plain.energy(all)) );
+        }
+#endif
+
         /**
          * @brief Multipolar decomposition between groups as a function of separation
          * @date Malmo 2014
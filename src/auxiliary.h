@@ -8,6 +8,20 @@
 #include <map>
 #include <regex>
 #include <chrono>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <numeric>
+#include <cstdlib>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 #include "average.h"
 
@@ -2026,12 +2040,14 @@ namespace Faunus
      * Time t=0 is set upon construction whereafter combined `start()`/
      * `stop()` calls can be made multiple times. The result is
      * the fraction of total time, consumed in between start/stop calls.
+     * The average time per start/stop interval is given by `mean()`.
      */
     template<typename Tunit = std::chrono::microseconds>
         class TimeRelativeOfTotal
         {
             private:
                 Tunit delta;
+                unsigned long cnt=0; // number of start/stop intervals
                 std::chrono::steady_clock::time_point t0, tx;
             public:
                 TimeRelativeOfTotal() : delta(0) {
@@ -2048,8 +2064,14 @@ namespace Faunus
                 {
                     delta += std::chrono::duration_cast<Tunit>
                         (std::chrono::steady_clock::now() - tx);
+                    cnt++;
                 }
 
+                double mean() const
+                {
+                    return cnt>0 ? delta.count() / double(cnt) : 0;
+                } //!< Average duration of start/stop intervals in units of `Tunit`
+
                 double result() const
                 {
                     auto now = std::chrono::steady_clock::now();
@@ -2086,6 +2108,359 @@ namespace Faunus
             }
     };
 
+    /**
+     * @brief Persistent worker thread for running a task concurrently with the caller
+     *
+     * Together with the calling thread this forms a two-thread executor:
+     * `run()` hands a task to the worker and returns immediately after
+     * which the caller can do other work before waiting for completion
+     * with `wait()`. The thread is created once and reused to avoid the
+     * cost of spawning a thread per task. Exceptions thrown by the task
+     * are re-thrown by `wait()`.
+     *
+     * ~~~ cpp
+     * WorkerThread worker;
+     * worker.run( [&]{ a = f(); } );
+     * b = g(); // runs concurrently with f()
+     * worker.wait();
+     * ~~~
+     */
+    class WorkerThread {
+        private:
+            std::mutex mutex;
+            std::condition_variable cv;
+            std::function<void()> task=nullptr;
+            std::exception_ptr error=nullptr;
+            bool busy=false, quit=false;
+            std::thread thread;
+
+            void loop() {
+                std::unique_lock<std::mutex> lock(mutex);
+                while (true) {
+                    cv.wait(lock, [this]{ return busy or quit; });
+                    if (quit)
+                        return;
+                    lock.unlock(); // task runs without holding the lock
+                    std::exception_ptr e=nullptr;
+                    try {
+                        task();
+                    } catch (...) {
+                        e = std::current_exception();
+                    }
+                    lock.lock();
+                    error = e;
+                    busy = false;
+                    cv.notify_all();
+                }
+            }
+
+        public:
+            WorkerThread() : thread(&WorkerThread::loop, this) {}
+
+            WorkerThread(const WorkerThread&) = delete;
+            WorkerThread& operator=(const WorkerThread&) = delete;
+
+            ~WorkerThread() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    quit = true;
+                }
+                cv.notify_all();
+                thread.join();
+            }
+
+            void run(std::function<void()> f) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [this]{ return not busy; });
+                    task = std::move(f);
+                    error = nullptr;
+                    busy = true;
+                }
+                cv.notify_all();
+            } //!< Start task in worker thread (waits for any previous task)
+
+            void wait() {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this]{ return not busy; });
+                if (error)
+                    std::rethrow_exception(error);
+            } //!< Wait for task to complete
+    };
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+    TEST_CASE("[Faunus] WorkerThread")
+    {
+        WorkerThread worker;
+        int a=0, b=0;
+        for (int i=0; i<100; i++) {
+            worker.run( [&a]{ a++; } );
+            b++;
+            worker.wait();
+        }
+        CHECK( a==100 );
+        CHECK( b==100 );
+        worker.run( []{ throw std::runtime_error("error"); } );
+        CHECK_THROWS( worker.wait() );
+        worker.run( [&a]{ a=0; } ); // still usable after exception
+        worker.wait();
+        CHECK( a==0 );
+    }
+#endif
+
+    /**
+     * @brief Timing of parallel calls, for reporting parallel efficiency
+     *
+     * The efficiency is the time spent in tasks divided by the wall time
+     * times the number of threads; one means perfect scaling.
+     */
+    struct ParallelStats {
+        size_t parallel=0; //!< Number of calls distributed over threads
+        size_t serial=0;   //!< Number of calls judged too small for threads
+        double wall=0;     //!< Wall time of parallel calls (s)
+        double busy=0;     //!< Summed task time of parallel calls (s)
+        int threads=1;     //!< Number of threads incl. the caller
+
+        double efficiency() const { return (wall>0) ? busy / (wall*threads) : 0; }
+    };
+
+    inline void to_json(json &j, const ParallelStats &s) {
+        j = { {"parallel calls", s.parallel}, {"serial calls", s.serial}, {"threads", s.threads} };
+        if (s.parallel>0)
+            j["efficiency"] = s.efficiency();
+    }
+
+    /**
+     * @brief Persistent pool of worker threads with work-stealing task queues
+     *
+     * Each worker owns a deque of tasks and takes from its back; when empty it
+     * steals from the front of the other deques and if nothing is found it
+     * sleeps until new tasks arrive. The thread calling `sum()` takes part in
+     * the work until its tasks are done so that calls may be nested or made
+     * from several threads. On Linux, workers may be pinned to cores with `pin()`.
+     *
+     * `sum()` splits a loop into at most `maxchunks` chunks whose partial sums
+     * are added in chunk order, so the result does not depend on the number of
+     * threads nor on which thread ran which chunk.
+     *
+     * ~~~ cpp
+     * double u = threadPool().sum(n, [&](size_t i){ return f(i); });
+     * ~~~
+     */
+    class ThreadPool {
+        private:
+            typedef std::function<void()> Ttask;
+            struct Queue {
+                std::mutex mutex;
+                std::deque<Ttask> tasks;
+            };
+            std::vector<std::unique_ptr<Queue>> queues; // one per worker
+            std::vector<std::thread> threads;
+            std::mutex mutex;
+            std::condition_variable cv;
+            std::atomic<size_t> queued{0}; // number of tasks in queues
+            std::atomic<size_t> next{0};   // queue to start from when submitting or helping
+            bool quit=false;
+
+            bool pop(size_t own, Ttask &task) {
+                for (size_t k=0; k<queues.size(); k++) {
+                    auto &q = *queues[(own+k) % queues.size()];
+                    std::lock_guard<std::mutex> lock(q.mutex);
+                    if (not q.tasks.empty()) {
+                        if (k==0) { // own queue
+                            task = std::move(q.tasks.back());
+                            q.tasks.pop_back();
+                        } else { // steal
+                            task = std::move(q.tasks.front());
+                            q.tasks.pop_front();
+                        }
+                        queued--;
+                        return true;
+                    }
+                }
+                return false;
+            } //!< Take task from queue `own`, or steal from other queues
+
+            void loop(size_t own) {
+                Ttask task;
+                while (true) {
+                    if (pop(own, task))
+                        task();
+                    else {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        cv.wait(lock, [this]{ return queued>0 or quit; });
+                        if (quit)
+                            return;
+                    }
+                }
+            }
+
+        public:
+            static constexpr size_t maxchunks = 64; //!< Max. number of chunks per `sum()` call
+
+            ThreadPool(size_t nworkers) {
+                for (size_t i=0; i<nworkers; i++)
+                    queues.emplace_back( new Queue );
+                for (size_t i=0; i<nworkers; i++)
+                    threads.emplace_back( &ThreadPool::loop, this, i );
+            }
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            ~ThreadPool() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    quit = true;
+                }
+                cv.notify_all();
+                for (auto &t : threads)
+                    t.join();
+            }
+
+            size_t size() const { return threads.size(); } //!< Number of worker threads
+
+            bool pin(size_t offset=1) {
+                bool success=true;
+#ifdef __linux__
+                size_t ncores = std::max(1u, std::thread::hardware_concurrency());
+                for (size_t i=0; i<threads.size(); i++) {
+                    cpu_set_t set;
+                    CPU_ZERO(&set);
+                    CPU_SET((offset+i) % ncores, &set);
+                    if (pthread_setaffinity_np(threads[i].native_handle(), sizeof(cpu_set_t), &set)!=0)
+                        success=false;
+                }
+#else
+                success=false;
+#endif
+                return success;
+            } //!< Pin worker `i` to core `offset+i`; false if unsupported or failed
+
+            /**
+             * @brief Parallel sum of `f(i)` for i in [0:n[
+             * @param n Number of elements
+             * @param f Function returning a double for each element
+             * @param stats Optional timing statistics to update
+             *
+             * The chunks are independent of the number of threads and are balanced
+             * by stealing. Exceptions thrown in `f` are re-thrown after all chunks
+             * have finished.
+             */
+            template<class Tfunction>
+                double sum(size_t n, Tfunction f, ParallelStats *stats=nullptr) {
+                    size_t nchunks = std::min(n, size_t(maxchunks));
+                    if (nchunks==0)
+                        return 0;
+                    size_t chunksize = (n + nchunks - 1) / nchunks;
+                    nchunks = (n + chunksize - 1) / chunksize;
+
+                    std::vector<double> partial(nchunks, 0), busy(nchunks, 0);
+                    std::atomic<size_t> remaining(nchunks);
+                    std::exception_ptr error=nullptr;
+                    std::mutex errormutex;
+                    auto t0 = std::chrono::steady_clock::now();
+
+                    auto run = [&](size_t k) {
+                        auto t = std::chrono::steady_clock::now();
+                        try {
+                            double s=0;
+                            for (size_t i=k*chunksize; i<std::min(n, (k+1)*chunksize); i++)
+                                s += f(i);
+                            partial[k] = s;
+                        } catch (...) {
+                            std::lock_guard<std::mutex> lock(errormutex);
+                            if (not error)
+                                error = std::current_exception();
+                        }
+                        busy[k] = std::chrono::duration<double>(std::chrono::steady_clock::now()-t).count();
+                        remaining--; // must be the last access to local data
+                    };
+
+                    if (threads.empty())
+                        for (size_t k=0; k<nchunks; k++)
+                            run(k);
+                    else {
+                        {
+                            std::lock_guard<std::mutex> lock(mutex);
+                            queued += nchunks-1;
+                        }
+                        size_t first = next++;
+                        for (size_t k=1; k<nchunks; k++) { // first chunk is kept by caller
+                            auto &q = *queues[(first+k) % queues.size()];
+                            std::lock_guard<std::mutex> lock(q.mutex);
+                            q.tasks.push_back( [&run,k]{ run(k); } );
+                        }
+                        cv.notify_all();
+                        run(0);
+                        Ttask task;
+                        while (remaining>0) // help until own chunks are done
+                            if (pop(next++, task))
+                                task();
+                            else
+                                std::this_thread::yield();
+                    }
+
+                    if (stats) {
+                        stats->parallel++;
+                        stats->threads = threads.size()+1;
+                        stats->wall += std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+                        stats->busy += std::accumulate(busy.begin(), busy.end(), 0.0);
+                    }
+                    if (error)
+                        std::rethrow_exception(error);
+                    return std::accumulate(partial.begin(), partial.end(), 0.0);
+                }
+    };
+
+    /**
+     * @brief Global thread pool with one worker per hardware thread, except for the caller
+     *
+     * Created at first use; the number of workers can be set with the
+     * environment variable `FAUNUS_THREADS` (total number of threads incl. the caller).
+     */
+    inline ThreadPool& threadPool() {
+        static ThreadPool pool( [] {
+                int n = std::thread::hardware_concurrency();
+                if (const char *env = std::getenv("FAUNUS_THREADS"))
+                    n = std::atoi(env);
+                return size_t( std::max(1, n) - 1 );
+                }() );
+        return pool;
+    }
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+    TEST_CASE("[Faunus] ThreadPool")
+    {
+        std::vector<double> v(1000);
+        for (size_t i=0; i<v.size(); i++)
+            v[i] = 1.0/(i+1);
+        auto f = [&v](size_t i){ return v[i]; };
+
+        ThreadPool serial(0);
+        double u0 = serial.sum(v.size(), f);
+        CHECK( u0 == doctest::Approx( std::accumulate(v.begin(), v.end(), 0.0) ) );
+
+        ThreadPool pool(3);
+        ParallelStats stats;
+        for (int n=0; n<100; n++)
+            CHECK( pool.sum(v.size(), f, &stats) == u0 ); // bitwise identical
+        CHECK( stats.parallel==100 );
+        CHECK( stats.threads==4 );
+        CHECK( stats.efficiency() >= 0 );
+        CHECK( pool.sum(0, f) == 0 );
+        CHECK( pool.sum(2, f) == doctest::Approx(1.5) );
+
+        double nested = pool.sum(10, [&](size_t){ return pool.sum(v.size(), f); });
+        CHECK( nested == doctest::Approx(10*u0) );
+
+        CHECK_THROWS( pool.sum(100, [](size_t i) -> double {
+                    if (i==42) throw std::runtime_error("error");
+                    return 0; }) );
+        CHECK( pool.sum(v.size(), f) == u0 ); // still usable after exception
+    }
+#endif
+
     /** @brief Count number of white-space separated words in a string */
     inline size_t numWords( const std::string &s )
     {
@@ -2153,6 +2528,49 @@ namespace Faunus
     }
 #endif
 
+    /**
+     * @brief Allocator returning memory aligned to `Alignment` bytes
+     *
+     * Useful for containers feeding vector instructions, e.g.
+     * `std::vector<double, AlignedAllocator<double>>` is aligned for AVX-512.
+     */
+    template<class T, std::size_t Alignment=64>
+        struct AlignedAllocator {
+            static_assert( (Alignment & (Alignment-1))==0, "alignment must be a power of two");
+            typedef T value_type;
+            template<class U> struct rebind { typedef AlignedAllocator<U,Alignment> other; };
+
+            AlignedAllocator() = default;
+            template<class U> AlignedAllocator(const AlignedAllocator<U,Alignment>&) {}
+
+            T* allocate(std::size_t n) {
+                void *raw = ::operator new( n*sizeof(T) + Alignment + sizeof(void*) );
+                std::uintptr_t address = reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*);
+                address = (address + Alignment - 1) & ~std::uintptr_t(Alignment - 1);
+                reinterpret_cast<void**>(address)[-1] = raw; // store original pointer just before
+                return reinterpret_cast<T*>(address);
+            }
+
+            void deallocate(T *ptr, std::size_t) {
+                ::operator delete( reinterpret_cast<void**>(ptr)[-1] );
+            }
+
+            template<class U> bool operator==(const AlignedAllocator<U,Alignment>&) const { return true; }
+            template<class U> bool operator!=(const AlignedAllocator<U,Alignment>&) const { return false; }
+        };
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+    TEST_CASE("[Faunus] AlignedAllocator")
+    {
+        std::vector<double, AlignedAllocator<double>> v;
+        for (int i=1; i<100; i++) {
+            v.resize(i, 1.0);
+            CHECK( reinterpret_cast<std::uintptr_t>(v.data()) % 64 == 0 );
+        }
+        CHECK( v.back()==1.0 );
+    }
+#endif
+
     template<typename T>
         struct BasePointerVector {
             std::vector<std::shared_ptr<T>> vec; //!< Vector of shared pointers to base class
@@ -0,0 +1,214 @@
+/*
+ * Micro-benchmarks for performance critical components
+ *
+ * Build with `make benchmarks` (not part of the default build) and run
+ * without arguments. Timings are printed in milliseconds.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <set>
+#include <random>
+#include <chrono>
+#include "celllist.h"
+#include "simd.h"
+
+using namespace Faunus;
+typedef Eigen::Vector3d Point;
+
+namespace {
+
+    /**
+     * @brief Stopwatch returning elapsed milliseconds of a callable
+     */
+    template<class Tfunction>
+        double milliseconds(Tfunction f) {
+            auto t0 = std::chrono::steady_clock::now();
+            f();
+            return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count();
+        }
+
+    void report(const std::string &name, double t_old, double t_new) {
+        std::cout << std::left << std::setw(36) << name << std::right
+            << std::setw(12) << t_old << std::setw(12) << t_new
+            << std::setw(10) << t_old/t_new << "x\n";
+    }
+
+    /**
+     * @brief Previous cell list implementation w. nested `std::set` storage (reference only)
+     */
+    class CellListNestedSet {
+        Point halfbox, cellsize;
+        std::vector<std::vector<std::vector<std::set<int>>>> cells;
+        public:
+        Eigen::Vector3i KLM;
+
+        void resize(const Point &box, double cutoff) {
+            halfbox = 0.5*box;
+            Eigen::Vector3i n = (box/cutoff).array().floor().cast<int>();
+            cellsize = box.cwiseQuotient( n.cast<double>() );
+            KLM = n - Eigen::Vector3i(1,1,1);
+            cells.resize(n[0]);
+            for (auto &k : cells) {
+                k.resize(n[1]);
+                for (auto &l : k)
+                    l.resize(n[2]);
+            }
+        }
+
+        Eigen::Vector3i p2c(const Point &p) const {
+            Eigen::Vector3i c = (p+halfbox).cwiseQuotient(cellsize).array().floor().cast<int>();
+            for (int d=0; d<3; d++)
+                c[d] = (c[d] % (KLM[d]+1) + KLM[d]+1) % (KLM[d]+1);
+            return c;
+        }
+
+        std::set<int>& operator[](const Eigen::Vector3i &c) { return cells[c[0]][c[1]][c[2]]; }
+
+        void move(int i, const Eigen::Vector3i &src, const Eigen::Vector3i &dst) {
+            (*this)[src].erase(i);
+            (*this)[dst].insert(i);
+        }
+
+        void neighbors(const Eigen::Vector3i &c, std::vector<int> &index) const {
+            index.clear();
+            for (int k=-1; k<=1; k++)
+                for (int l=-1; l<=1; l++)
+                    for (int m=-1; m<=1; m++) {
+                        Eigen::Vector3i d = c + Eigen::Vector3i(k,l,m);
+                        for (int i=0; i<3; i++)
+                            d[i] = (d[i] + KLM[i]+1) % (KLM[i]+1);
+                        auto &s = cells[d[0]][d[1]][d[2]];
+                        std::copy(s.begin(), s.end(), std::back_inserter(index));
+                    }
+        }
+    };
+
+    void benchmarkCellList(int N, double boxlen, double cutoff, int moves) {
+        std::mt19937 engine(1234);
+        std::uniform_real_distribution<double> unit(-0.5, 0.5);
+        auto ranpos = [&]() -> Point { return Point(unit(engine), unit(engine), unit(engine)) * boxlen; };
+
+        Point box(boxlen, boxlen, boxlen);
+        std::vector<Point> p(N);
+        for (auto &i : p)
+            i = ranpos();
+
+        // random particle index and displacements, shared by both implementations
+        std::vector<int> index(moves);
+        std::vector<Point> trial(moves);
+        for (int n=0; n<moves; n++) {
+            index[n] = std::uniform_int_distribution<int>(0, N-1)(engine);
+            trial[n] = ranpos();
+        }
+
+        std::cout << "\n# CellList: N=" << N << " box=" << boxlen << " cutoff=" << cutoff
+            << " moves=" << moves << "\n"
+            << std::left << std::setw(36) << "# operation" << std::right
+            << std::setw(12) << "nested set" << std::setw(12) << "flat" << std::setw(11) << "speedup\n";
+
+        CellListNestedSet a;
+        CellList<> b;
+        std::vector<Eigen::Vector3i> cell(N);
+
+        double t_old = milliseconds( [&]() {
+                a.resize(box, cutoff);
+                for (int i=0; i<N; i++) {
+                    cell[i] = a.p2c(p[i]);
+                    a[cell[i]].insert(i);
+                } } );
+        double t_new = milliseconds( [&]() {
+                b.resize(box, cutoff);
+                b.update(p); } );
+        report("build", t_old, t_new);
+
+        t_old = milliseconds( [&]() {
+                for (int n=0; n<moves; n++) {
+                    auto dst = a.p2c(trial[n]);
+                    if (dst!=cell[index[n]]) {
+                        a.move(index[n], cell[index[n]], dst);
+                        cell[index[n]] = dst;
+                    }
+                } } );
+        t_new = milliseconds( [&]() {
+                for (int n=0; n<moves; n++)
+                    b.move(index[n], b.p2i(trial[n])); } );
+        report("move", t_old, t_new);
+
+        size_t sum_old=0, sum_new=0;
+        std::vector<int> neighbors;
+        t_old = milliseconds( [&]() {
+                for (int n=0; n<moves; n++) {
+                    a.neighbors(a.p2c(trial[n]), neighbors);
+                    for (int j : neighbors)
+                        sum_old += j;
+                } } );
+        t_new = milliseconds( [&]() {
+                for (int n=0; n<moves; n++)
+                    b.forEachNeighbor( b.p2i(trial[n]), [&sum_new](int j){ sum_new += j; } ); } );
+        report("neighbor loop", t_old, t_new);
+
+        if (sum_old!=sum_new)
+            std::cerr << "error: cell lists disagree on neighbors\n";
+    }
+
+    void benchmarkSIMD(int N, double boxlen, int repeat) {
+        std::mt19937 engine(1234);
+        std::uniform_real_distribution<double> unit(-0.5, 0.5);
+        std::vector<double> x(N), y(N), z(N), charge(N);
+        std::vector<int> id(N);
+        for (int i=0; i<N; i++) {
+            x[i] = unit(engine) * boxlen;
+            y[i] = unit(engine) * boxlen;
+            z[i] = unit(engine) * boxlen;
+            charge[i] = (i%2==0) ? 1 : -1;
+            id[i] = i%2;
+        }
+        SIMD::Arrays a = {x.data(), y.data(), z.data(), charge.data(), id.data()};
+        SIMD::PairKernel k;
+        k.setBox(boxlen, boxlen, boxlen);
+        k.coulomb = SIMD::PairKernel::PLAIN;
+        k.lB = 7;
+        k.shortranged = SIMD::PairKernel::WCA;
+        k.ntypes = 2;
+        k.s2 = {16, 16, 16, 16};
+        k.eps = {0.4, 0.4, 0.4, 0.4};
+
+        std::cout << "\n# SIMD one-to-many (coulomb+wca): N=" << N << " repeat=" << repeat << "\n"
+            << std::left << std::setw(36) << "# instruction set" << std::right
+            << std::setw(12) << "scalar" << std::setw(12) << "simd" << std::setw(11) << "speedup\n";
+
+        auto run = [&]() {
+            double u=0;
+            for (int n=0; n<repeat; n++)
+                u += SIMD::oneToMany(k, x[n%N], y[n%N], z[n%N], charge[n%N], id[n%N], a, 0, n%N)
+                    + SIMD::oneToMany(k, x[n%N], y[n%N], z[n%N], charge[n%N], id[n%N], a, n%N+1, N);
+            return u;
+        };
+
+        double u_scalar, u_simd;
+        SIMD::setInstructionSet(SIMD::ISA::SCALAR);
+        double t_old = milliseconds( [&]() { u_scalar = run(); } );
+        for (auto isa : {SIMD::ISA::AVX2, SIMD::ISA::AVX512}) {
+            if (isa > SIMD::detect())
+                break;
+            SIMD::setInstructionSet(isa);
+            double t_new = milliseconds( [&]() { u_simd = run(); } );
+            report(SIMD::to_string(isa), t_old, t_new);
+            if (std::fabs(u_simd-u_scalar) > SIMD::tolerance*std::fabs(u_scalar))
+                std::cerr << "error: " << SIMD::to_string(isa) << " and scalar energies disagree\n";
+        }
+        SIMD::setInstructionSet(SIMD::detect());
+    }
+} // end of anonymous namespace
+
+int main() {
+    std::cout << std::fixed << std::setprecision(2);
+    benchmarkCellList(2000, 50, 10, 200000);
+    benchmarkCellList(20000, 100, 10, 200000);
+    benchmarkCellList(100000, 200, 8, 200000);
+    benchmarkSIMD(1000, 50, 20000);
+    benchmarkSIMD(10000, 100, 2000);
+    return 0;
+}
@@ -2,10 +2,12 @@
 
 #include <iostream>
 #include <vector>
-#include <set>
 #include <cassert>
 #include <cmath>
 #include <array>
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
 #include <Eigen/Core>
 
 namespace Faunus {
@@ -18,17 +20,19 @@ namespace Faunus {
      *
      * - cartesian space is assume to use all 8 octants (i.e. +/i round 0,0,0)
      * - grid space use only the first octant (all +)
-     * - resolution and size is set by `resize`
-     * - index of neighbors to a grid point
-     *   is obtained with `neighbors()`
-     * - index can be moved from one grid point to another with `move()`
-     * - the list of particle index in each grid point is stored in a
-     *   `std::set<int>` container.
+     * - resolution and size is set by `resize`; cells are never smaller
+     *   than the given cutoff so that all points within the cutoff of
+     *   a point are found in the 26+1 surrounding cells
+     * - points outside the box are wrapped into the periodic image
+     * - cells are stored as fixed-capacity buckets in a single contiguous
+     *   vector; the capacity grows automatically when a bucket overflows
+     * - index can be inserted, erased, or moved in constant time
+     * - particles in neighboring cells can be visited with `forEachNeighbor()`
+     *   without copying, while `neighbors()` copies them into a vector
+     * - `sync()` re-bins only the particles in a space touched by a `Change` object
      *
      * @todo
-     * - Update cell list based on Change object
      * - Make a non-periodic version
-     * - std::set --> set::vector?
      *
      * @date Malmo, March 2018
      */
@@ -36,81 +40,203 @@ namespace Faunus {
         class CellList {
             typedef Eigen::Vector3d Point;
             Point halfbox;
-            double cellsize=0; // cell side length (angstrom)
-            std::vector<std::vector<std::vector<std::set<int>>>> cells;
+            Point cellsize = {0,0,0};   // cell side lengths (angstrom)
+            double cutoff=0;            // minimum cell side length (angstrom)
+            int capacity=0;             // max. number of index in each cell (bucket size)
+            std::vector<int> buckets;   // all cells, each occupying `capacity` elements
+            std::vector<int> count;     // number of index in each cell
+            std::vector<int> slot;      // position in `buckets` of each index; -1 if absent
+            std::vector<int> neighbortable; // 27 neighbor cells for each cell
+
+            void reserve(int newcapacity) {
+                std::vector<int> v( count.size() * newcapacity );
+                for (size_t c=0; c<count.size(); c++)
+                    for (int k=0; k<count[c]; k++) {
+                        int i = buckets[c*capacity + k];
+                        v[c*newcapacity + k] = i;
+                        slot[i] = c*newcapacity + k;
+                    }
+                buckets.swap(v);
+                capacity = newcapacity;
+            } //!< Change bucket size while preserving content (complexity: N)
 
             public:
 
+            /** @brief Contiguous range of index in a cell */
+            struct Span {
+                const int *first, *last;
+                const int* begin() const { return first; }
+                const int* end() const { return last; }
+                size_t size() const { return last-first; }
+                bool empty() const { return first==last; }
+            };
+
             CellPoint KLM = {0,0,0}; // max cell index K,L,M
 
-            auto& operator[](const CellPoint &c) {
-                return cells[c[0]][c[1]][c[2]];
-            } //!< returns set with all index in given cell (complexity: constant)
+            int size() const { return count.size(); } //!< Number of cells
+
+            int c2i(const CellPoint &c) const {
+                return (c[0]*(KLM[1]+1) + c[1])*(KLM[2]+1) + c[2];
+            } //!< cell point --> cell index
 
             CellPoint p2c(const Point &p) const {
-                return ((p+halfbox)/cellsize).array().round().template cast<int>();
+                CellPoint c = (p+halfbox).cwiseQuotient(cellsize).array().floor().template cast<int>();
+                for (int d=0; d<3; d++) {
+                    c[d] = c[d] % (KLM[d]+1); // periodic wrap
+                    if (c[d]<0)
+                        c[d] += KLM[d]+1;
+                }
+                return c;
             } //!< cartesian point --> cell point
 
+            int p2i(const Point &p) const { return c2i(p2c(p)); } //!< cartesian point --> cell index
+
             Point c2p(const CellPoint &c) const {
-                return (c.template cast<double>()) * cellsize - halfbox;
-            } //!< cell point --> cartesian point
+                return (c.template cast<double>()).cwiseProduct(cellsize) - halfbox;
+            } //!< cell point --> cartesian point (lower corner of cell)
+
+            Span operator[](int c) const {
+                const int *first = buckets.data() + c*capacity;
+                return {first, first + count[c]};
+            } //!< returns all index in given cell (complexity: constant)
+
+            Span operator[](const CellPoint &c) const { return (*this)[c2i(c)]; }
+
+            int cell(int i) const {
+                return (i<int(slot.size()) && slot[i]>=0) ? slot[i]/capacity : -1;
+            } //!< cell index of particle index `i`; -1 if not in list (complexity: constant)
+
+            void insert(int i, int c) {
+                assert( cell(i)==-1 && "i already in list");
+                if (i>=int(slot.size()))
+                    slot.resize(i+1, -1);
+                if (count[c]==capacity)
+                    reserve(2*capacity);
+                slot[i] = c*capacity + count[c]++;
+                buckets[slot[i]] = i;
+            } //!< insert index into cell (complexity: amortized constant)
+
+            void erase(int i) {
+                assert( cell(i)>=0 && "i not present in list");
+                int c = slot[i]/capacity;
+                int last = c*capacity + --count[c];
+                buckets[slot[i]] = buckets[last]; // fill hole w. last index in cell
+                slot[buckets[last]] = slot[i];
+                slot[i] = -1;
+            } //!< remove index from list (complexity: constant)
+
+            void move(int i, int dst) {
+                if (cell(i)!=dst) {
+                    erase(i);
+                    insert(i, dst);
+                }
+            } //!< move index to another cell (complexity: constant)
 
             void move(int i, const CellPoint &src, const CellPoint &dst) {
-                assert( (*this)[src].count(i)==1 && "i not present in old cell");
-                assert( (*this)[dst].count(i)==0 && "i already in new cell");
-                (*this)[src].erase(i);
-                (*this)[dst].insert(i);
-            } //!< move particle index i from one cell to another (complexity: N log N)
+                assert( cell(i)==c2i(src) && "i not present in old cell");
+                move(i, c2i(dst));
+            } //!< move index from one cell to another (complexity: constant)
 
-            void resize(const Point &box, double cutoff) {
-                clear();
-                halfbox = 0.5*box;
-                cellsize = cutoff;
-                KLM = (box/cellsize).array().round().template cast<int>();
-                if (KLM.minCoeff()>=3) {
-                    cells.resize(KLM[0]+1);
-                    for (auto &k : cells) {
-                        k.resize(KLM[1]+1);
-                        for (auto &l : k)
-                            l.resize(KLM[2]+1);
-                    }
-                } else
+            void resize(const Point &box, const CellPoint &n) {
+                if (n.minCoeff()<3)
                     throw std::runtime_error("celllist error: too few grid point - cutoff or box too small");
-            }
+                halfbox = 0.5*box;
+                cellsize = box.cwiseQuotient( n.template cast<double>() );
+                cutoff = cellsize.minCoeff();
+                KLM = n - CellPoint(1,1,1);
+                count.assign( n.prod(), 0 );
+                capacity = std::max(capacity, 4);
+                buckets.assign( count.size()*capacity, -1 );
+                slot.assign( slot.size(), -1 );
+
+                // tabulate 26+1 neighbors for each cell
+                neighbortable.resize( 27*count.size() );
+                auto it = neighbortable.begin();
+                CellPoint c, d;
+                for (c[0]=0; c[0]<=KLM[0]; c[0]++)
+                    for (c[1]=0; c[1]<=KLM[1]; c[1]++)
+                        for (c[2]=0; c[2]<=KLM[2]; c[2]++)
+                            for (int k=-1; k<=1; k++)
+                                for (int l=-1; l<=1; l++)
+                                    for (int m=-1; m<=1; m++) {
+                                        d = c + CellPoint(k,l,m);
+                                        for (int i=0; i<3; i++)
+                                            d[i] = (d[i] + KLM[i]+1) % (KLM[i]+1); // periodic wrap
+                                        *it++ = c2i(d);
+                                    }
+                assert( it==neighbortable.end() );
+            } //!< Set box size and number of cells in each direction (clears all index)
+
+            void resize(const Point &box, double cutoff) {
+                resize( box, CellPoint( (box/cutoff).array().floor().template cast<int>() ) );
+                this->cutoff = cutoff;
+            } //!< Set box size and cutoff (clears all index)
+
+            Point cellSize() const { return cellsize; } //!< Cell side lengths
 
             void clear() {
-                for (auto &k : cells)
-                    for (auto &l : k)
-                        for (auto &m : l)
-                            m.clear();
+                std::fill(count.begin(), count.end(), 0);
+                std::fill(slot.begin(), slot.end(), -1);
             } //<! clear all index in cell list
 
             template<class Tpvec, class T=std::function<Point(const typename Tpvec::value_type&)>>
                 void update(const Tpvec &p, T getpos = [](auto &i){return i;} ) {
                     clear();
                     for (size_t i=0; i<p.size(); i++)
-                        (*this)[ p2c( getpos(p[i]) ) ].insert(i);
-                }
+                        insert(i, p2i( getpos(p[i]) ));
+                } //!< rebuild list from all points in vector
+
+            template<class Tspace>
+                void sync(const Tspace &spc, int i, bool active) {
+                    int c = (active) ? p2i( spc.p[i].pos ) : -1;
+                    if (c != cell(i)) {
+                        if (cell(i)>=0)
+                            erase(i);
+                        if (c>=0)
+                            insert(i, c);
+                    }
+                } //!< re-bin index `i` in space if it has changed cell or active state
+
+            template<class Tspace, class Tchange>
+                void sync(const Tspace &spc, const Tchange &change) {
+                    if (change.dV)
+                        resize( spc.geo.getLength(), cutoff );
+                    if (change.all || change.dV) {
+                        clear();
+                        for (auto &g : spc.groups) {
+                            int offset = g.begin() - spc.p.begin();
+                            for (int i=offset; i<offset+int(g.size()); i++)
+                                insert(i, p2i( spc.p[i].pos ));
+                        }
+                    } else
+                        for (auto &d : change.groups) {
+                            auto &g = spc.groups[d.index];
+                            int offset = g.begin() - spc.p.begin();
+                            int size = g.size();
+                            if (d.all || d.atoms.empty() || change.dN) // insertion/deletion may shuffle particles in group
+                                for (int i=0; i<int(g.capacity()); i++)
+                                    sync(spc, offset+i, i<size);
+                            else
+                                for (int i : d.atoms)
+                                    sync(spc, offset+i, i<size);
+                        }
+                } //!< re-bin active particles in space touched by a `Change` object
 
-            void neighbors(const Eigen::Vector3i &c, std::vector<int> &index, bool clear=true) const {
+            const int* neighborCells(int c) const {
+                return neighbortable.data() + 27*c;
+            } //!< pointer to the index of the 26+1 neighboring+own cells of cell `c`
+
+            template<class Tfunction>
+                void forEachNeighbor(int c, Tfunction f) const {
+                    for (const int *n = neighborCells(c), *end = n+27; n!=end; ++n)
+                        for (int i : (*this)[*n])
+                            f(i);
+                } //!< call `f(i)` for all index in the 26+1 neighboring+own cells (complexity: N neighbors)
+
+            void neighbors(const CellPoint &c, std::vector<int> &index, bool clear=true) const {
                 if (clear)
                     index.clear();
-                int cnt=0;
-                std::array<int,3>
-                    k = {{ c[0]-1, c[0], c[0]+1 }},
-                    l = {{ c[1]-1, c[1], c[1]+1 }},
-                    m = {{ c[2]-1, c[2], c[2]+1 }};
-                if (k[0]<0) k[0]=KLM[0]; else if (k[2]>KLM[0]) k[2]=0;
-                if (l[0]<0) l[0]=KLM[1]; else if (l[2]>KLM[1]) l[2]=0;
-                if (m[0]<0) m[0]=KLM[2]; else if (m[2]>KLM[2]) m[2]=0;
-                for (int _k : k)
-                    for (int _l : l)
-                        for (int _m : m) {
-                            cnt++;
-                            auto& s = cells[_k][_l][_m];
-                            std::copy(s.begin(), s.end(), std::back_inserter(index));
-                        }
-                assert(cnt==27);
+                forEachNeighbor( c2i(c), [&index](int i){ index.push_back(i); } );
             } //!< Index from all 26+1 neighboring+own cells (complexity: N neighbors)
         };
 
@@ -121,26 +247,70 @@ namespace Faunus {
         Point box = {10,20,6};
         CellList<Eigen::Vector3i> l;
         l.resize(box, 2);
-        CHECK( l.KLM==Eigen::Vector3i(5,10,3) );
-        CHECK( l.p2c( {5,10,3} ) == l.KLM );
+        CHECK( l.KLM==Eigen::Vector3i(4,9,2) );
+        CHECK( l.size()==5*10*3 );
+        CHECK( l.p2c( {5,10,3} ) == Eigen::Vector3i(0,0,0) ); // periodic image
         CHECK( l.p2c( {-5,-10,-3} ) == Eigen::Vector3i(0,0,0) );
-        CHECK( l.p2c( {0,0,0} ) == Eigen::Vector3i(3,5,2) );
+        CHECK( l.p2c( {0,0,0} ) == Eigen::Vector3i(2,5,1) );
+        CHECK( l.p2c( {4.9,9.9,2.9} ) == l.KLM );
+        CHECK( l.c2p( l.p2c({0.1,0.1,0.1}) ) == Point(-1,0,-1) );
+        CHECK( l.c2i( l.KLM ) == l.size()-1 );
+
+        CellList<Eigen::Vector3i> l2;
+        l2.resize({10,10,10}, 3.1); // cells must not be smaller than the cutoff
+        CHECK( l2.KLM==Eigen::Vector3i(2,2,2) );
+        l2.resize({10,12,16}, Eigen::Vector3i(4,4,8)); // explicit number of cells
+        CHECK( l2.KLM==Eigen::Vector3i(3,3,7) );
+        CHECK( l2.cellSize()==Point(2.5,3,2) );
+        CHECK_THROWS( l2.resize({10,10,10}, Eigen::Vector3i(4,2,4)) );
 
         std::vector<int> index; // index of neighbors (and self) in...
         std::vector<Point> vec; // ...array of points
 
-        vec = {{0,0,0}, {0,3,0}};
+        vec = {{0,0,0}, {0,5,0}};
         l.update(vec);
         l.neighbors( l.p2c( vec[0] ), index);
         CHECK( index.size()==1 );  // alone by myself...
         CHECK( index.front()==0 ); // ...am I really me?
 
-        vec = {{0,0,0}, {0,-3,0}};
+        vec = {{0,0,0}, {0,-1.5,0}};
         l.update(vec);
         l.neighbors( l.p2c( vec[0] ), index);
         CHECK( index.size()==2 );  // now we're two
         l.neighbors( l.p2c( vec[1] ), index);
         CHECK( index.size()==2 );  // now we're two
+
+        vec = {{0,-9.5,0}, {0,9.5,0}}; // neighbors across the periodic boundary
+        l.update(vec);
+        l.neighbors( l.p2c( vec[0] ), index);
+        CHECK( index.size()==2 );
+
+        SUBCASE("insert, erase, move") {
+            l.clear();
+            int c0 = l.p2i({0,0,0}), c1 = l.p2i({0,5,0});
+            for (int i=0; i<10; i++) // exceed initial bucket capacity
+                l.insert(i, c0);
+            CHECK( l[c0].size()==10 );
+            CHECK( l.cell(9)==c0 );
+            l.erase(3);
+            CHECK( l.cell(3)==-1 );
+            CHECK( l[c0].size()==9 );
+            CHECK( std::count(l[c0].begin(), l[c0].end(), 3)==0 );
+            l.move(9, c1);
+            CHECK( l.cell(9)==c1 );
+            CHECK( l[c0].size()==8 );
+            CHECK( l[c1].size()==1 );
+            CHECK( *l[c1].begin()==9 );
+            l.move(9, l.p2c({0,5,0}), l.p2c({0,0,0}));
+            CHECK( l.cell(9)==c0 );
+            CHECK( l[c1].empty() );
+
+            int n=0;
+            l.forEachNeighbor(c0, [&n](int){ n++; });
+            CHECK( n==9 );
+            l.forEachNeighbor(c1, [&n](int){ n++; });
+            CHECK( n==9 ); // c1 is not adjacent to c0
+        }
     }
 #endif
 } // namespace
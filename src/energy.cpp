@@ -1,12 +1,26 @@
 
 #include "energy.h"
+#include <unsupported/Eigen/FFT>
 
 void Faunus::Energy::Energybase::to_json(json&) const {}
 
 void Faunus::Energy::Energybase::sync(Energybase*, Change&) {}
 
+double Faunus::Energy::Energybase::delta(Change &change, Energybase *old) {
+    assert(old!=nullptr);
+    return energy(change) - old->energy(change);
+} // fallback for terms without a fused implementation
+
 void Faunus::Energy::Energybase::init() {}
 
+double Faunus::Energy::Energybase::interactionRange() const {
+    return -1; // particle energies not supported
+}
+
+double Faunus::Energy::Energybase::particleEnergy(int, const std::vector<int>&) {
+    throw std::runtime_error(name + ": particle energies not supported");
+}
+
 void Faunus::Energy::to_json(json &j, const Energybase &base) {
     assert(not base.name.empty());
     if (base.timer) 
@@ -23,15 +37,18 @@ void Faunus::Energy::EwaldData::update(const Point &box) {
     int kVectorsLength = (2*kcc+1) * (2*kcc+1) * (2*kcc+1) - 1;
     if (kVectorsLength == 0) {
         kVectors.resize(3,1);
+        kIndices.setZero(3,1);
         Aks.resize(1);
         kVectors.col(0) = Point(1,0,0); // Just so it is not the zero-vector
         Aks[0] = 0;
         kVectorsInUse = 1;
-        Qion.resize(1);
+        QionRe.resize(1);
+        QionIm.resize(1);
         Qdip.resize(1);
     } else {
         double kc2 = kc*kc;
         kVectors.resize(3, kVectorsLength);
+        kIndices.resize(3, kVectorsLength);
         Aks.resize(kVectorsLength);
         kVectorsInUse = 0;
         kVectors.setZero();
@@ -58,16 +75,87 @@ void Faunus::Energy::EwaldData::update(const Point &box) {
                         if( (dkx2/kc2) + (dky2/kc2) + (dkz2/kc2) > 1)
                             continue;
                     kVectors.col(kVectorsInUse) = kv;
+                    kIndices.col(kVectorsInUse) = Eigen::Vector3i(kx,ky,kz);
                     Aks[kVectorsInUse] = factor*std::exp(-k2/(4*alpha*alpha))/k2;
                     kVectorsInUse++;
                 }
             }
         }
-        Qion.resize(kVectorsInUse);
+        QionRe.resize(kVectorsInUse);
+        QionIm.resize(kVectorsInUse);
         Qdip.resize(kVectorsInUse);
         Aks.conservativeResize(kVectorsInUse);
         kVectors.conservativeResize(3,kVectorsInUse);
+        kIndices.conservativeResize(3,kVectorsInUse);
+    }
+}
+
+void Faunus::Energy::EwaldRecurrence::add(EwaldData &d, const Point &r, double charge) {
+    for (int i=0; i<3; i++)
+        pos[i].push_back(r[i]);
+    weight.push_back(charge);
+    if (weight.size() == 64) // small enough to keep the phase factors in cache
+        flush(d);
+}
+
+void Faunus::Energy::EwaldRecurrence::flush(EwaldData &d) {
+    while (weight.size() % 4 != 0) { // pad with zero charges to match the unrolled loops below
+        for (auto &x : pos)
+            x.push_back(0);
+        weight.push_back(0);
+    }
+    const int n = weight.size(), nmax = std::max(0, int(std::ceil(d.kc)));
+    if (n==0)
+        return;
+
+    // phase factors exp(i*m*theta) for m=0..nmax along each axis
+    for (int i=0; i<3; i++) {
+        c[i].resize( (nmax+1)*n );
+        s[i].resize( (nmax+1)*n );
+        for (int j=0; j<n; j++) {
+            double theta = 2*pc::pi*pos[i][j] / d.L[i];
+            c[i][j] = 1;
+            s[i][j] = 0;
+            if (nmax>0) {
+                c[i][n+j] = std::cos(theta);
+                s[i][n+j] = std::sin(theta);
+            }
+        }
+        for (int m=2; m<=nmax; m++) {
+            const double *c0=&c[i][(m-1)*n], *s0=&s[i][(m-1)*n], *c1=&c[i][n], *s1=&s[i][n];
+            double *cm=&c[i][m*n], *sm=&s[i][m*n];
+            for (int j=0; j<n; j++) {
+                cm[j] = c0[j]*c1[j] - s0[j]*s1[j];
+                sm[j] = s0[j]*c1[j] + c0[j]*s1[j];
+            }
+        }
+    }
+
+    const double *q = weight.data();
+    for (int k=0; k<d.kIndices.cols(); k++) {
+        int nx=d.kIndices(0,k), ny=d.kIndices(1,k), nz=d.kIndices(2,k);
+        const double *cx=&c[0][std::abs(nx)*n], *cy=&c[1][std::abs(ny)*n], *cz=&c[2][std::abs(nz)*n];
+        const double *sx=&s[0][std::abs(nx)*n], *sy=&s[1][std::abs(ny)*n], *sz=&s[2][std::abs(nz)*n];
+        double gx = (nx<0) ? -1 : 1, gy = (ny<0) ? -1 : 1, gz = (nz<0) ? -1 : 1; // conjugate if negative
+        double re[4] = {0,0,0,0}, im[4] = {0,0,0,0}; // independent partial sums allow vectorisation
+        if (d.ipbc)
+            for (int j=0; j<n; j+=4)
+                for (int l=0; l<4; l++)
+                    re[l] += q[j+l] * cx[j+l] * cy[j+l] * cz[j+l];
+        else
+            for (int j=0; j<n; j+=4)
+                for (int l=0; l<4; l++) {
+                    double a = cx[j+l]*cy[j+l] - gx*gy*sx[j+l]*sy[j+l]; // exp(i*(kx*x+ky*y))
+                    double b = gy*cx[j+l]*sy[j+l] + gx*sx[j+l]*cy[j+l];
+                    re[l] += q[j+l] * (a*cz[j+l] - gz*b*sz[j+l]);
+                    im[l] += q[j+l] * (gz*a*sz[j+l] + b*cz[j+l]);
+                }
+        d.QionRe[k] += (re[0]+re[1]) + (re[2]+re[3]);
+        d.QionIm[k] += (im[0]+im[1]) + (im[2]+im[3]);
     }
+    for (auto &x : pos)
+        x.clear();
+    weight.clear();
 }
 
 void Faunus::Energy::from_json(const json &j, EwaldData &d) {
@@ -76,15 +164,247 @@ void Faunus::Energy::from_json(const json &j, EwaldData &d) {
     d.kc = j.at("kcutoff");
     d.ipbc = j.value("ipbc", false);
     d.spherical_sum = j.value("spherical_sum", true);
+    d.recurrence = j.value("recurrence", false);
     d.lB = pc::lB( j.at("epsr") );
     d.eps_surf = j.value("epss", 0.0);
     d.const_inf = (d.eps_surf < 1) ? 0 : 1; // if unphysical (<1) use epsr infinity for surrounding medium
+    auto it = j.find("auto"); // results from `tuneEwald()`
+    if (it!=j.end() and it->is_object()) {
+        d.tolerance = it->value("tolerance", 0.0);
+        d.predictedError = it->value("predicted error", 0.0);
+        d.pairTime = it->value("pair time", 0.0);
+        d.kvectorTime = it->value("k-vector time", 0.0);
+    }
 }
 
 void Faunus::Energy::to_json(json &j, const EwaldData &d) {
     j = {{"lB", d.lB}, {"ipbc", d.ipbc}, {"epss", d.eps_surf},
         {"alpha", d.alpha}, {"cutoff", d.rc}, {"kcutoff", d.kc},
-        {"wavefunctions", d.kVectors.cols()}, {"spherical_sum", d.spherical_sum}};
+        {"wavefunctions", d.kVectors.cols()}, {"spherical_sum", d.spherical_sum},
+        {"recurrence", d.recurrence}};
+    if (d.tolerance>0)
+        j["auto"] = {{"tolerance", d.tolerance}, {"predicted error", d.predictedError},
+            {"pair time", d.pairTime}, {"k-vector time", d.kvectorTime}};
+}
+
+double Faunus::Energy::EwaldTuning::realSpaceError(double alpha, double rc) const {
+    double x = alpha*rc;
+    return lB * chargeSquared * std::sqrt( rc/(2*L.prod()) ) * std::exp(-x*x) / (x*x);
+}
+
+double Faunus::Energy::EwaldTuning::reciprocalError(double alpha, double kc) const {
+    double x = pc::pi*kc / (alpha*L.maxCoeff()); // longest side has the shortest k cutoff
+    return lB * chargeSquared * alpha / (pc::pi*pc::pi) * std::pow(kc, -1.5) * std::exp(-x*x);
+}
+
+void Faunus::Energy::EwaldTuning::optimize() {
+    const double target = tolerance / std::sqrt(2); // share squared error equally
+    const int kcmax = 100;
+    std::vector<double> cutoffs;
+    if (cutoff>0)
+        cutoffs.push_back(cutoff);
+    else
+        for (int i=1; i<=40; i++)
+            cutoffs.push_back( 0.5*L.minCoeff()*i/40 );
+
+    cost = pc::infty;
+    for (double r : cutoffs) {
+        double lo=1e-3/r, hi=10/r; // real space error decreases with alpha
+        if (realSpaceError(hi, r) > target)
+            continue;
+        for (int i=0; i<60; i++) {
+            double mid = 0.5*(lo+hi);
+            if (realSpaceError(mid, r) > target)
+                lo = mid;
+            else
+                hi = mid;
+        }
+        int k=1;
+        while (k<kcmax and reciprocalError(hi, k) > target)
+            k++;
+        if (reciprocalError(hi, k) > target)
+            continue;
+
+        EwaldData d; // count k-vectors
+        d.alpha = hi;
+        d.kc = k;
+        d.ipbc = ipbc;
+        d.spherical_sum = spherical_sum;
+        d.update(L);
+
+        double c = pairTime * N/L.prod() * 4*pc::pi/3*r*r*r + kvectorTime * d.kVectors.cols();
+        if (c < cost) {
+            cost = c;
+            alpha = hi;
+            rc = r;
+            kc = k;
+        }
+    }
+    if (cost == pc::infty)
+        throw std::runtime_error("ewald: tolerance cannot be reached");
+    error = std::sqrt( std::pow(realSpaceError(alpha, rc), 2) + std::pow(reciprocalError(alpha, kc), 2) );
+}
+
+namespace {
+    /*
+     * Cardinal B-spline of order `order` at w+j for j=0..order-1 where w is in [0:1[,
+     * i.e. the weights of the grid points floor(u)-j for a charge at u=floor(u)+w.
+     */
+    void bspline(double w, int order, std::vector<double> &m) {
+        m.assign(order, 0);
+        m[0] = w; // second order
+        m[1] = 1-w;
+        for (int k=3; k<=order; k++)
+            for (int j=k-1; j>=0; j--)
+                m[j] = ( (w+j)*m[j] + (k-w-j)*(j>0 ? m[j-1] : 0) ) / (k-1);
+    }
+
+    int fftSize(int n) {
+        for (;; n++) { // smallest number >= n with factors 2, 3, and 5 only
+            int m=n;
+            for (int f : {2,3,5})
+                while (m%f==0)
+                    m/=f;
+            if (m==1)
+                return n;
+        }
+    }
+
+    /*
+     * In-place 3D FFT of a grid with z running fastest, by 1D transforms along each axis
+     */
+    void transform(std::vector<std::complex<double>> &a, const Eigen::Vector3i &K, bool forward) {
+        Eigen::FFT<double> fft;
+        std::vector<std::complex<double>> in, out;
+        int stride[3] = {K[1]*K[2], K[2], 1};
+        for (int d=0; d<3; d++) {
+            in.resize(K[d]);
+            for (int i=0; i<int(a.size()); i++)
+                if ( (i/stride[d]) % K[d] == 0 ) { // first point of a line along d
+                    for (int j=0; j<K[d]; j++)
+                        in[j] = a[i+j*stride[d]];
+                    if (forward)
+                        fft.fwd(out, in);
+                    else
+                        fft.inv(out, in); // scaled by 1/K[d]
+                    for (int j=0; j<K[d]; j++)
+                        a[i+j*stride[d]] = out[j];
+                }
+        }
+    }
+}
+
+void Faunus::Energy::PMEData::update(const Point &box) {
+    Eigen::Vector3i n;
+    for (int d=0; d<3; d++)
+        n[d] = fftSize( std::max(order, int(std::ceil(box[d]/spacing))) );
+    if (box==L and n==K)
+        return;
+    L = box;
+    K = n;
+    size_t size = K.prod();
+    Q.assign(size, 0);
+    psi.assign(size, 0);
+    G.assign(size, 0);
+
+    // |b(m)|^2 for B-spline interpolation of the structure factor (Eq. 4.4 in doi:10.1063/1.470117)
+    std::vector<double> M, B[3];
+    bspline(0, order, M); // M[j] is the spline at integer j
+    for (int d=0; d<3; d++) {
+        B[d].resize(K[d]);
+        for (int m=0; m<K[d]; m++) {
+            std::complex<double> s = 0;
+            for (int k=0; k<order-1; k++)
+                s += M[k+1] * std::polar(1.0, 2*pc::pi*m*k/K[d]);
+            B[d][m] = (std::norm(s) > 1e-14) ? 1/std::norm(s) : 0; // zero for odd orders at m=K/2
+        }
+    }
+
+    for (int x=0; x<K[0]; x++)
+        for (int y=0; y<K[1]; y++)
+            for (int z=0; z<K[2]; z++) {
+                int m[3] = {x,y,z};
+                double k2=0, b=1;
+                for (int d=0; d<3; d++) {
+                    double k = 2*pc::pi * ( (m[d] <= K[d]/2) ? m[d] : m[d]-K[d] ) / L[d];
+                    k2 += k*k;
+                    b *= B[d][m[d]];
+                }
+                if (k2>0)
+                    G[(x*K[1]+y)*K[2]+z] = b * std::exp(-k2/(4*alpha*alpha)) / k2;
+            }
+
+    std::vector<std::complex<double>> a(G.begin(), G.end());
+    transform(a, K, false);
+    T.resize(size);
+    for (size_t i=0; i<size; i++)
+        T[i] = a[i].real() * size;
+}
+
+void Faunus::Energy::PMEData::spread(const Point &pos, double charge, Tstencil &stencil) const {
+    std::vector<double> w[3];
+    int first[3];
+    for (int d=0; d<3; d++) {
+        double s = pos[d]/L[d];
+        double u = K[d] * (s - std::floor(s)); // in [0:K[
+        double f = std::floor(u);
+        first[d] = int(f);
+        bspline(u-f, order, w[d]);
+    }
+    for (int i=0; i<order; i++) {
+        int x = ( (first[0]-i) % K[0] + K[0] ) % K[0];
+        for (int j=0; j<order; j++) {
+            int y = ( (first[1]-j) % K[1] + K[1] ) % K[1];
+            for (int k=0; k<order; k++) {
+                int z = ( (first[2]-k) % K[2] + K[2] ) % K[2];
+                stencil.push_back( {(x*K[1]+y)*K[2]+z, charge*w[0][i]*w[1][j]*w[2][k]} );
+            }
+        }
+    }
+}
+
+void Faunus::Energy::PMEData::convolve() {
+    size_t size = Q.size();
+    std::vector<std::complex<double>> a(Q.begin(), Q.end());
+    transform(a, K, true);
+    for (size_t i=0; i<size; i++)
+        a[i] *= G[i];
+    transform(a, K, false);
+    qpsi = 0;
+    for (size_t i=0; i<size; i++) {
+        psi[i] = a[i].real() * size;
+        qpsi += Q[i] * psi[i];
+    }
+}
+
+double Faunus::Energy::PMEData::delta(const Tstencil &stencil) const {
+    double du = 0;
+    for (auto &a : stencil) {
+        du += 2 * a.second * psi[a.first];
+        int ax = a.first / (K[1]*K[2]), ay = (a.first/K[2]) % K[1], az = a.first % K[2];
+        for (auto &b : stencil) {
+            int bx = b.first / (K[1]*K[2]), by = (b.first/K[2]) % K[1], bz = b.first % K[2];
+            int x = (ax-bx+K[0]) % K[0], y = (ay-by+K[1]) % K[1], z = (az-bz+K[2]) % K[2];
+            du += a.second * b.second * T[(x*K[1]+y)*K[2]+z];
+        }
+    }
+    return du;
+}
+
+void Faunus::Energy::from_json(const json &j, PMEData &d) {
+    d.alpha = j.at("alpha");
+    d.lB = pc::lB( j.at("epsr") );
+    d.order = j.value("order", 6);
+    d.spacing = j.value("spacing", 1.0);
+    d.eps_surf = j.value("epss", 0.0);
+    d.const_inf = (d.eps_surf < 1) ? 0 : 1; // if unphysical (<1) use epsr infinity for surrounding medium
+    if (d.order<2 or d.spacing<=0)
+        throw std::runtime_error("spme: order must be >= 2 and spacing positive");
+}
+
+void Faunus::Energy::to_json(json &j, const PMEData &d) {
+    j = {{"lB", d.lB}, {"epss", d.eps_surf}, {"alpha", d.alpha}, {"order", d.order},
+        {"spacing", d.spacing}, {"grid", {d.K[0], d.K[1], d.K[2]}}};
 }
 
 double Faunus::Energy::Example2D::energy(Change&) {
@@ -7,8 +7,12 @@
 #include "multipole.h"
 #include "penalty.h"
 #include "mpi.h"
+#include "celllist.h"
+#include "simd.h"
 #include <Eigen/Dense>
 #include <set>
+#include <map>
+#include <numeric>
 
 #ifdef ENABLE_POWERSASA
 #include <power_sasa.h>
@@ -21,14 +25,20 @@ namespace Faunus {
             public:
                 enum keys {OLD, NEW, NONE};
                 keys key=NONE;
+                bool concurrent=true; //!< Safe to evaluate concurrently with the same term of the other state
+                bool undoable=true;   //!< Old energy can be evaluated in the same space after undoing a move (no `sync()` needed)
+                bool nonnegative=false; //!< Energy change of a move can never be negative (see `Hamiltonian::delta()`)
                 std::string name;
                 std::string cite;
                 TimeRelativeOfTotal<std::chrono::microseconds> timer;
                 virtual double energy(Change&)=0; //!< energy due to change
+                virtual double delta(Change&, Energybase *old); //!< energy change relative to `old` state
                 virtual void to_json(json &j) const; //!< json output
                 virtual void sync(Energybase*, Change&);
                 virtual void init(); //!< reset and initialize
                 virtual inline void force(std::vector<Point>&) {}; // update forces on all particles
+                virtual double interactionRange() const; //!< Distance beyond which `particleEnergy()` is zero; negative if unsupported
+                virtual double particleEnergy(int i, const std::vector<int> &neighbors); //!< Energy of particle `i` with `neighbors` (thread safe; see `interactionRange()`)
                 inline virtual ~Energybase() {};
         };
 
@@ -45,6 +55,7 @@ namespace Faunus {
                 const Tspace &spc;
                 ContainerOverlap(const Tspace &spc) : spc(spc) {
                     name = "ContainerOverlap";
+                    nonnegative = true; // the accepted state never overlaps
                 }
                 double energy(Change &change) override {
                     //if (spc.geo.type not_eq Geometry::Chameleon::CUBOID) // cuboid have PBC in all directions
@@ -76,6 +87,12 @@ namespace Faunus {
                         }
                     return 0;
                 }
+
+                double interactionRange() const override { return 0; }
+
+                double particleEnergy(int i, const std::vector<int>&) override {
+                    return spc.geo.collision( spc.p[i].pos ) ? pc::infty : 0;
+                }
             };
 
         /**
@@ -84,13 +101,21 @@ namespace Faunus {
         struct EwaldData {
             typedef std::complex<double> Tcomplex;
             Eigen::Matrix3Xd kVectors; // k-vectors, 3xK
+            Eigen::Matrix3Xi kIndices; //!< Integer wave-vectors, n, where k=2*pi*n/L (3xK)
             Eigen::VectorXd Aks;       // 1xK, to minimize computational effort (Eq.24,DOI:10.1063/1.481216)
-            Eigen::VectorXcd Qion, Qdip; // 1xK
+            Eigen::VectorXd QionRe, QionIm; //!< Real and imaginary parts of ion structure factor (1xK)
+            Eigen::VectorXcd Qdip; // 1xK
+            double chargeSquared=0;    //!< Sum of squared charges of active particles (self energy)
+            Point dipole={0,0,0};      //!< Sum of charge times position of active particles (surface energy)
             double alpha, rc, kc, check_k2_zero, lB;
             double const_inf, eps_surf;
             bool spherical_sum=true;
             bool ipbc=false;
+            bool recurrence=false;     //!< Generate structure factors by trigonometric recurrence
             int kVectorsInUse=0;
+            double tolerance=0;        //!< Target RMS energy error if parameters are automatic
+            double predictedError=0;   //!< Predicted RMS energy error if parameters are automatic
+            double pairTime=0, kvectorTime=0; //!< Timings used for automatic parameters (s)
             Point L; //!< Box dimensions
 
             void update(const Point &box);
@@ -100,6 +125,27 @@ namespace Faunus {
 
         void to_json(json &j, const EwaldData &d);
 
+        /**
+         * @brief Ion structure factors by trigonometric recurrence
+         *
+         * Rather than calling `cos` and `sin` for every particle and k-vector, the one
+         * dimensional phase factors @f$e^{in\theta_\alpha}@f$ with
+         * @f$\theta_\alpha=2\pi r_\alpha/L_\alpha@f$ are generated for @f$n=0\ldots n_{max}@f$
+         * along each axis by repeated complex multiplication with @f$e^{i\theta_\alpha}@f$.
+         * Each k-vector then needs only the product of three such factors (negative @f$n@f$
+         * are complex conjugates) or, for IPBC, of their real parts.
+         * Particles are queued in small blocks stored as a structure of arrays with the
+         * particle index running fastest so that the inner loop over particles vectorises.
+         */
+        class EwaldRecurrence {
+            private:
+                std::vector<double> pos[3], weight; // queued positions and charges
+                std::vector<double> c[3], s[3];     // cos(n*theta) and sin(n*theta), particle index fastest
+            public:
+                void add(EwaldData &d, const Point &pos, double charge); //!< Queue charge for addition to `QionRe` and `QionIm`
+                void flush(EwaldData &d); //!< Add all queued charges to the structure factors
+        };
+
 #ifdef DOCTEST_LIBRARY_INCLUDED
         TEST_CASE("[Faunus] Ewald - EwaldData")
         {
@@ -115,95 +161,202 @@ namespace Faunus {
             CHECK(data.const_inf == 1);
             CHECK(data.alpha == 0.894427190999916);
             CHECK(data.kVectors.cols() == 2975);
-            CHECK(data.Qion.size() == data.kVectors.cols());
+            CHECK(data.QionRe.size() == data.kVectors.cols());
+            CHECK(data.kIndices.cols() == data.kVectors.cols());
 
             data.ipbc=true;
             data.update( Point(10,10,10) );
             CHECK(data.kVectors.cols() == 846);
-            CHECK(data.Qion.size() == data.kVectors.cols());
+            CHECK(data.QionRe.size() == data.kVectors.cols());
+            CHECK(data.kIndices.cols() == data.kVectors.cols());
         }
 #endif
 
-        /** @brief recipe or policies for ion-ion ewald */
+        struct TouchedParticle {
+            size_t index;   //!< Particle index
+            bool active;    //!< Active in the trial state
+            bool wasactive; //!< Active in the old state
+        }; //!< Particle touched by a move
+
+        /*
+         * Particles touched by `change`, i.e. atom subsets or whole groups, sorted by index.
+         * The old and trial group sizes determine if a particle has been activated
+         * or deactivated.
+         */
+        template<class Tspace>
+            std::vector<TouchedParticle> touchedParticles(const Tspace &spc, const Tspace &old, const Change &change) {
+                std::vector<TouchedParticle> touched;
+                for (auto &d : change.groups) {
+                    auto &g = spc.groups.at(d.index);
+                    size_t first = std::distance(spc.p.begin(), typename Tspace::Tpvec::const_iterator(g.begin()));
+                    int size = g.size(), oldsize = old.groups.at(d.index).size();
+                    auto add = [&](int i) {
+                        if (i<size or i<oldsize)
+                            touched.push_back( {first+i, i<size, i<oldsize} );
+                    };
+                    if (d.all or d.atoms.empty())
+                        for (int i=0; i<std::max(size, oldsize); i++)
+                            add(i);
+                    else
+                        for (int i : d.atoms)
+                            add(i);
+                }
+                std::sort(touched.begin(), touched.end(), [](auto &a, auto &b){ return a.index<b.index; });
+                touched.erase( std::unique(touched.begin(), touched.end(),
+                            [](auto &a, auto &b){ return a.index==b.index; }), touched.end() );
+                return touched;
+            }
+
+        /**
+         * @brief recipe or policies for ion-ion ewald
+         *
+         * Only active particles contribute, and the self energy and surface dipole are kept as
+         * running sums in `EwaldData` which are updated together with the structure factors. Particles that are
+         * activated or deactivated (`Change::dN`) are added to or removed from the sums so
+         * that insertions and deletions cost as much as moving the same particles.
+         */
         template<class Tspace, bool eigenopt=false /** use Eigen matrix ops where possible */>
             struct PolicyIonIon  {
                 typedef typename Tspace::Tpvec::iterator iter;
                 Tspace *spc;
                 Tspace *old=nullptr; // set only if key==NEW at first call to `sync()`
 
+                mutable EwaldRecurrence recurrence;
+
                 PolicyIonIon(Tspace &spc) : spc(&spc) {}
 
                 void updateComplex(EwaldData &data) const {
+                    data.chargeSquared = 0;
+                    data.dipole.setZero();
+                    for (auto &g : spc->groups)
+                        for (auto &i : g) {
+                            data.chargeSquared += i.charge * i.charge;
+                            data.dipole += i.charge * i.pos;
+                        }
+                    if (data.recurrence) {
+                        data.QionRe.setZero();
+                        data.QionIm.setZero();
+                        for (auto &g : spc->groups)
+                            for (auto &i : g)
+                                recurrence.add(data, i.pos, i.charge);
+                        recurrence.flush(data);
+                        return;
+                    }
                     if (eigenopt)
                         if (data.ipbc==false) {
-                            auto pos = asEigenMatrix(spc->p.begin(), spc->p.end(), &Tspace::Tparticle::pos); //  Nx3
-                            auto charge = asEigenVector(spc->p.begin(), spc->p.end(), &Tspace::Tparticle::charge); // Nx1
-                            Eigen::MatrixXd kr = pos.matrix() * data.kVectors; // Nx3 * 3xK = NxK
-                            data.Qion.real() = (kr.array().cos().colwise()*charge).colwise().sum();
-                            data.Qion.imag() = kr.array().sin().colwise().sum();
+                            data.QionRe.setZero();
+                            data.QionIm.setZero();
+                            for (auto &g : spc->groups)
+                                if (not g.empty()) {
+                                    auto pos = asEigenMatrix(g.begin(), g.end(), &Tspace::Tparticle::pos); //  Nx3
+                                    auto charge = asEigenVector(g.begin(), g.end(), &Tspace::Tparticle::charge); // Nx1
+                                    Eigen::MatrixXd kr = pos.matrix() * data.kVectors; // Nx3 * 3xK = NxK
+                                    data.QionRe += (kr.array().cos().colwise()*charge).colwise().sum().transpose().matrix();
+                                    data.QionIm += (kr.array().sin().colwise()*charge).colwise().sum().transpose().matrix();
+                                }
                             return;
                         }
                     for (int k=0; k<data.kVectors.cols(); k++) {
                         const Point& kv = data.kVectors.col(k);
                         EwaldData::Tcomplex Q(0,0);
                         if (data.ipbc)
-                            for (auto &i : spc->p)
-                                Q += kv.cwiseProduct(i.pos).array().cos().prod() * i.charge;
+                            for (auto &g : spc->groups)
+                                for (auto &i : g)
+                                    Q += kv.cwiseProduct(i.pos).array().cos().prod() * i.charge;
                         else
-                            for (auto &i : spc->p) {
-                                double dot = kv.dot(i.pos);
-                                Q += i.charge * EwaldData::Tcomplex( std::cos(dot), std::sin(dot) );
-                            }
-                        data.Qion[k] = Q;
+                            for (auto &g : spc->groups)
+                                for (auto &i : g) {
+                                    double dot = kv.dot(i.pos);
+                                    Q += i.charge * EwaldData::Tcomplex( std::cos(dot), std::sin(dot) );
+                                }
+                        data.QionRe[k] = Q.real();
+                        data.QionIm[k] = Q.imag();
                     }
-                } //!< Update all k vectors
+                } //!< Update all k vectors and running sums from active particles
 
-                void updateComplex(EwaldData &data, iter begin, iter end) const {
+                void updateComplex(EwaldData &data, const std::vector<TouchedParticle> &touched) const {
                     assert(old!=nullptr);
                     assert(spc->p.size() == old->p.size());
-                    size_t ibeg = std::distance(spc->p.begin(), begin); // it->index
-                    size_t iend = std::distance(spc->p.begin(), end);   // it->index
+                    for (auto &t : touched) {
+                        auto &a = spc->p[t.index], &b = old->p[t.index];
+                        if (t.active) {
+                            data.chargeSquared += a.charge * a.charge;
+                            data.dipole += a.charge * a.pos;
+                        }
+                        if (t.wasactive) {
+                            data.chargeSquared -= b.charge * b.charge;
+                            data.dipole -= b.charge * b.pos;
+                        }
+                    }
+                    if (data.recurrence) {
+                        for (auto &t : touched) {
+                            if (t.active)
+                                recurrence.add(data, spc->p[t.index].pos, spc->p[t.index].charge);
+                            if (t.wasactive)
+                                recurrence.add(data, old->p[t.index].pos, -old->p[t.index].charge);
+                        }
+                        recurrence.flush(data);
+                        return;
+                    }
                     for (int k=0; k<data.kVectors.cols(); k++) {
-                        auto& Q = data.Qion[k];
+                        EwaldData::Tcomplex Q(data.QionRe[k], data.QionIm[k]);
                         Point q = data.kVectors.col(k);
                         if (data.ipbc)
-                            for (size_t i=ibeg; i<=iend; i++) {
-                                Q +=  q.cwiseProduct( spc->p[i].pos ).array().cos().prod() * spc->p[i].charge;
-                                Q -=  q.cwiseProduct( old->p[i].pos ).array().cos().prod() * old->p[i].charge;
+                            for (auto &t : touched) {
+                                if (t.active)
+                                    Q +=  q.cwiseProduct( spc->p[t.index].pos ).array().cos().prod() * spc->p[t.index].charge;
+                                if (t.wasactive)
+                                    Q -=  q.cwiseProduct( old->p[t.index].pos ).array().cos().prod() * old->p[t.index].charge;
                             }
                         else
-                            for (size_t i=ibeg; i<=iend; i++) {
-                                double _new = q.dot(spc->p[i].pos);
-                                double _old = q.dot(old->p[i].pos);
-                                Q += spc->p[i].charge * EwaldData::Tcomplex( std::cos(_new), std::sin(_new) );
-                                Q -= old->p[i].charge * EwaldData::Tcomplex( std::cos(_old), std::sin(_old) );
+                            for (auto &t : touched) {
+                                if (t.active) {
+                                    double _new = q.dot(spc->p[t.index].pos);
+                                    Q += spc->p[t.index].charge * EwaldData::Tcomplex( std::cos(_new), std::sin(_new) );
+                                }
+                                if (t.wasactive) {
+                                    double _old = q.dot(old->p[t.index].pos);
+                                    Q -= old->p[t.index].charge * EwaldData::Tcomplex( std::cos(_old), std::sin(_old) );
+                                }
                             }
+                        data.QionRe[k] = Q.real();
+                        data.QionIm[k] = Q.imag();
                     }
-                } //!< Optimized update of k subset. Require access to old positions through `old` pointer
+                } //!< Optimized update of `touched` particles. Require access to old positions through `old` pointer
+
+                /*
+                 * Update k vectors for all particles touched by `change` so that the cost
+                 * scales with the number of moved charges. If more than half of the active
+                 * particles have been touched, all k vectors are recalculated.
+                 */
+                void updateComplex(EwaldData &data, const Change &change) const {
+                    auto touched = touchedParticles(*spc, *old, change);
+                    size_t nactive=0;
+                    for (auto &g : spc->groups)
+                        nactive += g.size();
+                    if (2*touched.size() > nactive)
+                        updateComplex(data);
+                    else
+                        updateComplex(data, touched);
+                } //!< Update k vectors for particles touched by `change`
 
                 double selfEnergy(const EwaldData &d) {
-                    double E = 0;
-                    for (auto& i : spc->p)
-                        E += i.charge * i.charge;
-                    return -d.alpha*E / std::sqrt(pc::pi) * d.lB;
+                    return -d.alpha*d.chargeSquared / std::sqrt(pc::pi) * d.lB;
                 }
 
                 double surfaceEnergy(const EwaldData &d) {
                     if (d.const_inf < 0.5)
                         return 0;
-                    Point qr(0,0,0);
-                    for (auto &i : spc->p)
-                        qr += i.charge*i.pos;
-                    return d.const_inf * 2 * pc::pi / ( (2*d.eps_surf+1) * spc->geo.getVolume() ) * qr.dot(qr) * d.lB;
+                    return d.const_inf * 2 * pc::pi / ( (2*d.eps_surf+1) * spc->geo.getVolume() ) * d.dipole.dot(d.dipole) * d.lB;
                 }
 
                 double reciprocalEnergy(const EwaldData &d) {
                     double E = 0;
                     if (eigenopt) // known at compile time
-                        E = d.Aks.cwiseProduct( d.Qion.cwiseAbs2() ).sum();
+                        E = d.Aks.cwiseProduct( d.QionRe.cwiseAbs2() + d.QionIm.cwiseAbs2() ).sum();
                     else
-                        for (int k=0; k<d.Qion.size(); k++)
-                            E += d.Aks[k] * std::norm( d.Qion[k] );
+                        for (int k=0; k<d.QionRe.size(); k++)
+                            E += d.Aks[k] * ( d.QionRe[k]*d.QionRe[k] + d.QionIm[k]*d.QionIm[k] );
                     return 2 * pc::pi / spc->geo.getVolume() * E * d.lB;
                 }
             };
@@ -219,6 +372,7 @@ namespace Faunus {
             spc.geo  = R"( {"type": "cuboid", "length": 10} )"_json;
             spc.p[0] = R"( {"pos": [0,0,0], "q": 1.0} )"_json;
             spc.p[1] = R"( {"pos": [1,0,0], "q": -1.0} )"_json;
+            spc.groups.emplace_back(spc.p.begin(), spc.p.end());
 
             PolicyIonIon<Tspace> ionion(spc);
             EwaldData data = R"({
@@ -238,6 +392,101 @@ namespace Faunus {
             CHECK( ionion.selfEnergy(data) == Approx(-1.0092530088080642*data.lB) );
             CHECK( ionion.surfaceEnergy(data) == Approx(0.0020943951023931952*data.lB) );
             CHECK( ionion.reciprocalEnergy(data) == Approx(0.0865107467*data.lB) );
+
+            data.recurrence = true; // trigonometric recurrence must reproduce the above
+            for (bool ipbc : {false, true}) {
+                data.ipbc = ipbc;
+                data.update( spc.geo.getLength() );
+                ionion.updateComplex( data );
+                CHECK( ionion.selfEnergy(data) == Approx(-1.0092530088080642*data.lB) );
+                CHECK( ionion.surfaceEnergy(data) == Approx(0.0020943951023931952*data.lB) );
+                CHECK( ionion.reciprocalEnergy(data) == Approx( (ipbc ? 0.0865107467 : 0.21303063979675319)*data.lB) );
+            }
+        }
+
+        TEST_CASE("[Faunus] Ewald - incremental update")
+        {
+            typedef Space<Geometry::Chameleon, Particle<Charge,Dipole>> Tspace;
+
+            Tspace spc, old;
+            spc.geo = R"( {"type": "cuboid", "length": 10} )"_json;
+            spc.p.resize(20);
+            for (size_t i=0; i<spc.p.size(); i++) {
+                spc.p[i].pos = Point( std::fmod(1.7*i, 10), std::fmod(3.1*i, 10), std::fmod(0.9*i, 10) ) - Point(5,5,5);
+                spc.p[i].charge = (i%2==0) ? 1 : -1;
+            }
+            old.p = spc.p;
+            for (auto v : {&spc, &old}) {
+                v->groups.emplace_back(v->p.begin(), v->p.begin()+8);
+                v->groups.emplace_back(v->p.begin()+8, v->p.begin()+16);
+                v->groups.emplace_back(v->p.begin()+16, v->p.end());
+            }
+
+            PolicyIonIon<Tspace> ionion(spc);
+            ionion.old = &old;
+            EwaldData data = R"({
+                "epsr": 1.0, "alpha": 0.894427190999916, "epss": 1.0,
+                "kcutoff": 11.0, "spherical_sum": true, "cutoff": 5.0})"_json;
+
+            auto accept = [&]() {
+                old.p = spc.p;
+                for (size_t k=0; k<spc.groups.size(); k++)
+                    old.groups[k].end() = old.groups[k].begin() + spc.groups[k].size();
+            };
+
+            auto check = [&](Change &change) {
+                ionion.updateComplex(data, change);
+                EwaldData incremental = data;
+                ionion.updateComplex(data);
+                CHECK( (incremental.QionRe - data.QionRe).cwiseAbs().maxCoeff() < 1e-10 );
+                CHECK( (incremental.QionIm - data.QionIm).cwiseAbs().maxCoeff() < 1e-10 );
+                CHECK( incremental.chargeSquared == doctest::Approx(data.chargeSquared) );
+                CHECK( (incremental.dipole - data.dipole).norm() < 1e-10 );
+                EwaldData other = data; // the two structure factor engines must agree
+                other.recurrence = not data.recurrence;
+                ionion.updateComplex(other);
+                CHECK( (other.QionRe - data.QionRe).cwiseAbs().maxCoeff() < 1e-10 );
+                CHECK( (other.QionIm - data.QionIm).cwiseAbs().maxCoeff() < 1e-10 );
+                accept();
+            };
+
+            for (bool recurrence : {false, true})
+            for (bool ipbc : {false, true}) {
+                data.recurrence = recurrence;
+                data.ipbc = ipbc;
+                data.update( spc.geo.getLength() );
+                ionion.updateComplex(data);
+
+                Change change; // atom subsets and a whole group in three groups
+                change.groups.resize(3);
+                change.groups[0].index = 0;
+                change.groups[0].atoms = {1};
+                change.groups[1].index = 1;
+                change.groups[1].atoms = {0,2};
+                change.groups[2].index = 2;
+                change.groups[2].all = true;
+                for (int i : {1, 8, 10, 16, 17, 18, 19}) {
+                    spc.p[i].pos += Point(0.3, -0.2, 0.1);
+                    spc.p[i].charge *= 0.5;
+                }
+                check(change);
+
+                auto &g = spc.groups[2];
+                change.clear(); // deactivate the last two atoms
+                change.dN = true;
+                change.groups.resize(1);
+                change.groups[0].index = 2;
+                change.groups[0].atoms = {2,3};
+                g.deactivate(g.end()-2, g.end());
+                check(change);
+
+                change.groups[0].atoms = {2}; // activate one atom at a new position
+                g.activate(g.end(), g.end()+1);
+                g.begin()[2].pos = Point(1,2,3);
+                check(change);
+                g.activate(g.end(), g.end()+1);
+                accept();
+            }
         }
 #endif
 
@@ -252,6 +501,8 @@ namespace Faunus {
 
                     Ewald(const json &j, Tspace &spc) : policy(spc), spc(spc) {
                         name = "ewald";
+                        concurrent = false; // trial state reads the old space via `policy.old`
+                        undoable = false;   // k-vectors are updated only in the trial state
                         data = j;
                         init();
                     }
@@ -270,17 +521,8 @@ namespace Faunus {
                                     data.update( spc.geo.getLength() );
                                     policy.updateComplex(data);    // update all (expensive!)
                                 }
-                                else {
-                                    if (change.groups.size()==1) { // exactly one group is moved
-                                        auto& d = change.groups[0];
-                                        auto& g = spc.groups[d.index];
-                                        if (d.atoms.size()==1)     // exactly one atom is moved
-                                            policy.updateComplex(data, g.begin()+d.atoms[0], g.begin()+d.atoms[0]);
-                                        else
-                                            policy.updateComplex(data, g.begin(), g.end());
-                                    } else
-                                        policy.updateComplex(data);
-                                }
+                                else
+                                    policy.updateComplex(data, change); // only moved particles
                             }
                             u = policy.selfEnergy(data) + policy.surfaceEnergy(data) + policy.reciprocalEnergy(data);
                         }
@@ -301,6 +543,489 @@ namespace Faunus {
                     }
             };
 
+        /**
+         * @brief Ewald parameters for a target accuracy at minimum cost
+         *
+         * RMS errors of the real and reciprocal space energies are estimated as in
+         * Kolafa and Perram (doi:10.1080/08927029208049126) and each gets half of the squared `tolerance`.
+         * For each trial cutoff, `alpha` is the smallest damping that meets the real space
+         * target and `kc` the smallest integer meeting the reciprocal target. The cost per
+         * particle is the time per pair times the number of neighbours within the cutoff
+         * plus the time per k-vector times the number of k-vectors; the cheapest set wins.
+         */
+        struct EwaldTuning {
+            double tolerance=0.01;  //!< Target RMS energy error (kT)
+            double chargeSquared=0; //!< Sum of squared charges
+            double lB=0;            //!< Bjerrum length
+            int N=0;                //!< Number of particles
+            Point L={0,0,0};        //!< Box dimensions
+            bool ipbc=false, spherical_sum=true;
+            double pairTime=0;      //!< Time per pair interaction (s)
+            double kvectorTime=0;   //!< Time per particle and k-vector (s)
+            double cutoff=0;        //!< Fixed real space cutoff; optimised if zero
+
+            double alpha=0, rc=0, kc=0; //!< Optimal parameters
+            double error=0, cost=0;     //!< Predicted RMS error and time per particle (s)
+
+            double realSpaceError(double alpha, double rc) const;
+            double reciprocalError(double alpha, double kc) const;
+            void optimize(); //!< Find cheapest `alpha`, `rc`, and `kc` within `tolerance`
+        };
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+        TEST_CASE("[Faunus] Ewald - EwaldTuning")
+        {
+            EwaldTuning t;
+            t.tolerance = 0.001;
+            t.chargeSquared = 2;
+            t.lB = 7;
+            t.N = 2;
+            t.L = Point(10,10,10);
+            t.pairTime = 1e-8;
+            t.kvectorTime = 1e-8;
+            t.cutoff = 5; // as in "[Faunus] Ewald - EwaldData" which uses 2975 k-vectors
+            t.optimize();
+            CHECK( t.rc == 5 );
+            CHECK( t.error <= t.tolerance * (1+1e-6) );
+            CHECK( t.realSpaceError(t.alpha, t.rc) <= t.tolerance );
+            CHECK( t.reciprocalError(t.alpha, t.kc) <= t.tolerance );
+            CHECK( t.realSpaceError(0.9*t.alpha, t.rc) > t.tolerance / std::sqrt(2) ); // smallest alpha
+            CHECK( t.reciprocalError(t.alpha, t.kc-1) > t.tolerance / std::sqrt(2) );  // smallest kc
+
+            EwaldData d = R"({"epsr": 1.0, "cutoff": 5.0, "kcutoff": 1.0, "alpha": 1.0})"_json;
+            d.alpha = t.alpha;
+            d.kc = t.kc;
+            d.update(t.L);
+            CHECK( d.kVectors.cols() < 2975 );
+
+            t.cutoff = 0; // free cutoff in a dense system: costly k-vectors favour a longer cutoff
+            t.N = 1000;
+            t.chargeSquared = 1000;
+            t.kvectorTime = 1e-6;
+            t.optimize();
+            double rc1 = t.rc;
+            t.kvectorTime = 1e-10;
+            t.optimize();
+            CHECK( t.rc < rc1 );
+            CHECK( t.error <= t.tolerance * (1+1e-6) );
+        }
+#endif
+
+        inline void optimizeEwald(json &j, EwaldTuning &t) {
+            t.optimize();
+            j["alpha"] = t.alpha;
+            j["cutoff"] = t.rc;
+            j["kcutoff"] = t.kc;
+            j["auto"] = {{"tolerance", t.tolerance}, {"predicted error", t.error},
+                {"real space error", t.realSpaceError(t.alpha, t.rc)},
+                {"reciprocal error", t.reciprocalError(t.alpha, t.kc)},
+                {"pair time", t.pairTime}, {"k-vector time", t.kvectorTime}};
+        } //!< Optimise `t` and write the chosen parameters to the Ewald json object `j`
+
+        /**
+         * @brief Replace `alpha`, `cutoff`, and `kcutoff` in an Ewald json object by tuned values
+         *
+         * The time per pair interaction and per particle and k-vector are measured on
+         * (a subset of) the active particles in `spc`, using the same pair potential and
+         * k-space engine as in the simulation, unless given as `pair time` and `k-vector time`
+         * in `auto`. A `cutoff` given in the input is kept. The chosen values, the timings,
+         * and the predicted error are written back to `j`.
+         */
+        template<class Tspace>
+            void tuneEwald(json &j, const Tspace &spc) {
+                typedef std::chrono::steady_clock clock;
+                auto seconds = [](clock::time_point t0) {
+                    return std::chrono::duration<double>(clock::now()-t0).count(); };
+
+                EwaldTuning t;
+                const json &a = j.at("auto");
+                if (a.is_object()) {
+                    t.tolerance = a.value("tolerance", t.tolerance);
+                    t.pairTime = a.value("pair time", 0.0); // pinned timings make the result reproducible
+                    t.kvectorTime = a.value("k-vector time", 0.0);
+                }
+                t.lB = pc::lB( j.at("epsr") );
+                t.L = spc.geo.getLength();
+                t.ipbc = j.value("ipbc", false);
+                t.spherical_sum = j.value("spherical_sum", true);
+                t.cutoff = j.value("cutoff", 0.0);
+
+                typename Tspace::Tpvec p; // active particles
+                for (auto &g : spc.groups)
+                    for (auto &i : g) {
+                        p.push_back(i);
+                        t.chargeSquared += i.charge * i.charge;
+                    }
+                t.N = p.size();
+                if (t.N < 2)
+                    throw std::runtime_error("ewald: at least two particles required for automatic parameters");
+                if (t.pairTime>0 and t.kvectorTime>0) {
+                    optimizeEwald(j, t);
+                    return;
+                }
+                p.resize( std::min(p.size(), size_t(500)) ); // probes run on a subset
+
+                json probe = j; // arbitrary but valid parameters for timing
+                probe["alpha"] = 1.0;
+                probe["cutoff"] = t.L.norm(); // include all pairs
+                probe["kcutoff"] = 5.0;
+
+                Potential::CoulombGalore pot;
+                pot.from_json(probe);
+                double u=0;
+                size_t npairs=0;
+                auto t0 = clock::now();
+                do {
+                    for (size_t i=0; i<p.size(); i++)
+                        for (size_t k=i+1; k<p.size(); k++)
+                            u += pot(p[i], p[k], spc.geo.sqdist(p[i].pos, p[k].pos));
+                    npairs += p.size()*(p.size()-1)/2;
+                } while (seconds(t0) < 0.02);
+                t.pairTime = seconds(t0) / npairs;
+                if (std::isnan(u))
+                    throw std::runtime_error("ewald: real space timing probe failed");
+
+                Tspace sub;
+                sub.geo = spc.geo;
+                sub.p = p;
+                sub.groups.emplace_back(sub.p.begin(), sub.p.end());
+                EwaldData data = probe;
+                data.update(t.L);
+                PolicyIonIon<Tspace> policy(sub);
+                size_t n=0;
+                t0 = clock::now();
+                do {
+                    policy.updateComplex(data);
+                    n++;
+                } while (seconds(t0) < 0.02);
+                t.kvectorTime = seconds(t0) / ( n * p.size() * data.kVectors.cols() );
+                optimizeEwald(j, t);
+            }
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+        TEST_CASE("[Faunus] Ewald - tuneEwald")
+        {
+            typedef Space<Geometry::Chameleon, Particle<Charge>> Tspace;
+
+            SaltFixture<Tspace> salt( R"( {"type": "cuboid", "length": 20} )"_json );
+            salt.addSalt(100);
+            auto &spc = salt.spc;
+
+            // pinned timings give the same parameters on every run and rank
+            json j = R"({"type": "ewald", "epsr": 80,
+                "auto": {"tolerance": 0.01, "pair time": 1e-8, "k-vector time": 1e-8}})"_json;
+            json j2 = j;
+            tuneEwald(j, spc);
+            tuneEwald(j2, spc);
+            CHECK( j == j2 );
+            CHECK( j["auto"]["pair time"] == 1e-8 );
+            CHECK( j["cutoff"].get<double>() <= 10 );
+            CHECK( j["auto"]["predicted error"].get<double>() <= 0.01 * (1+1e-6) );
+
+            EwaldData d = j; // timings are kept for the report
+            CHECK( d.pairTime == 1e-8 );
+            CHECK( json(d)["auto"]["k-vector time"] == 1e-8 );
+        }
+#endif
+
+        /**
+         * @brief Energy input `j` with tuned Ewald parameters if `j["coulomb"]` is `ewald` with `auto`
+         *
+         * Tuning is done once per input and box; later calls, e.g. for the trial state
+         * Hamiltonian, return the cached result so that all states use identical parameters.
+         */
+        template<class Tspace>
+            const json& autoEwald(const json &j, const Tspace &spc) {
+                auto it = j.find("coulomb");
+                if (it==j.end() or not it->is_object() or it->count("auto")==0
+                        or it->value("type", std::string())!="ewald")
+                    return j;
+                static std::map<std::string, json> cache;
+                json &tuned = cache[ j.dump() + json(spc.geo.getLength()).dump() ];
+                if (tuned.is_null()) {
+                    tuned = j;
+#ifdef ENABLE_MPI
+                    if (MPI::mpi.nproc()>1) { // timings differ between ranks; use those of the master
+                        json master;
+                        if (MPI::mpi.isMaster()) {
+                            tuneEwald(tuned["coulomb"], spc);
+                            master = tuned["coulomb"];
+                        }
+                        master = json::parse( MPI::broadcast(MPI::mpi, master.dump()) );
+                        for (auto key : {"alpha", "cutoff", "kcutoff", "auto"})
+                            tuned["coulomb"][key] = master.at(key);
+                        return tuned;
+                    }
+#endif
+                    tuneEwald(tuned["coulomb"], spc);
+                }
+                return tuned;
+            }
+
+        /**
+         * @brief Setup and grids for smooth particle-mesh Ewald (SPME)
+         *
+         * Charges are spread onto a periodic grid, @f$Q@f$, by cardinal B-splines of
+         * order `order` and the reciprocal energy is
+         * @f$ \frac{2\pi l_B}{V}\sum_{\bf x} Q({\bf x})\psi({\bf x}) @f$ where
+         * @f$ \psi = T\star Q @f$ is the convolution with the real space kernel, @f$T@f$,
+         * i.e. the inverse transform of the influence function, @f$G@f$ (Essmann et al.).
+         * Grids are stored with the z index running fastest.
+         */
+        struct PMEData {
+            typedef std::vector<std::pair<int,double>> Tstencil; //!< Sparse grid charges (index, value)
+            double alpha, lB;
+            double const_inf, eps_surf;
+            double spacing=1;           //!< Max. grid spacing
+            int order=6;                //!< B-spline order (grid points per dimension and charge)
+            Eigen::Vector3i K={0,0,0};  //!< Number of grid points in each dimension
+            Point L={0,0,0};            //!< Box dimensions
+            std::vector<double> Q;      //!< Charge grid
+            std::vector<double> psi;    //!< Convolution of `Q` with `T`
+            std::vector<double> G;      //!< Influence function in reciprocal space
+            std::vector<double> T;      //!< Real space kernel
+            double qpsi=0;              //!< Sum of Q times psi (reciprocal energy w/o prefactor)
+            double chargeSquared=0;     //!< Sum of squared charges of active particles (self energy)
+            Point dipole={0,0,0};       //!< Sum of charge times position of active particles (surface energy)
+
+            void update(const Point &box); //!< Resize grids and set up `G` and `T` if box has changed
+            void spread(const Point &pos, double charge, Tstencil &stencil) const; //!< Append B-spline stencil of a charge
+            void convolve(); //!< Update `psi` and `qpsi` from `Q` by FFT
+            double delta(const Tstencil &stencil) const; //!< Change in `qpsi` if merged `stencil` is added to `Q`
+        };
+
+        void from_json(const json &j, PMEData &d);
+
+        void to_json(json &j, const PMEData &d);
+
+        /**
+         * @brief Smooth particle-mesh Ewald reciprocal, self, and surface energies
+         *
+         * This replaces `Ewald` for large systems where the number of k-vectors needed
+         * for a given accuracy becomes prohibitive. For moves that touch only a few
+         * particles, the B-spline stencils of the old and new positions give the
+         * grid change, @f$\Delta Q@f$, and the energy change is
+         * @f$ 2\sum_{\bf x}\Delta Q({\bf x})\psi({\bf x}) + \sum_{\bf x,y}\Delta Q({\bf x})T({\bf x-y})\Delta Q({\bf y}) @f$
+         * using `psi` of the accepted state. Grids are updated by FFT only when a move is
+         * accepted, and only in the old state from which they are copied to the trial state.
+         */
+        template<class Tspace>
+            class PME : public Energybase {
+                private:
+                    PMEData data;
+                    PMEData::Tstencil pending; // grid changes of the current trial move
+                    double dqpsi=0, dchargeSquared=0;
+                    Point ddipole={0,0,0};
+                    bool rebuilt=false;        // true if grids have been rebuilt in the trial state
+                    Tspace &spc;
+                    Tspace *old=nullptr;       // set only if key==NEW at first call to `sync()`
+
+                    void rebuild() {
+                        data.chargeSquared = 0;
+                        data.dipole.setZero();
+                        std::fill(data.Q.begin(), data.Q.end(), 0);
+                        PMEData::Tstencil stencil;
+                        for (auto &g : spc.groups)
+                            for (auto &i : g) {
+                                data.chargeSquared += i.charge * i.charge;
+                                data.dipole += i.charge * i.pos;
+                                stencil.clear();
+                                data.spread(i.pos, i.charge, stencil);
+                                for (auto &s : stencil)
+                                    data.Q[s.first] += s.second;
+                            }
+                        data.convolve();
+                    } //!< Recalculate everything from active particles
+
+                    void clear() {
+                        pending.clear();
+                        dqpsi = dchargeSquared = 0;
+                        ddipole.setZero();
+                        rebuilt = false;
+                    } //!< Forget trial move
+
+                public:
+                    PME(const json &j, Tspace &spc) : spc(spc) {
+                        name = "spme";
+                        cite = "doi:10.1063/1.470117";
+                        concurrent = false; // trial state reads the old space via `old`
+                        undoable = false;   // grids are updated via `sync()`
+                        data = j;
+                        init();
+                    }
+
+                    void init() override {
+                        clear();
+                        data.update( spc.geo.getLength() );
+                        rebuild();
+                    }
+
+                    double energy(Change &change) override {
+                        if (not change)
+                            return 0;
+                        if (key==NEW) {
+                            clear();
+                            if (change.all or change.dV or old==nullptr) {
+                                data.update( spc.geo.getLength() );
+                                rebuild();
+                                rebuilt = true;
+                            } else {
+                                for (auto &t : touchedParticles(spc, *old, change)) {
+                                    if (t.active) {
+                                        auto &i = spc.p[t.index];
+                                        dchargeSquared += i.charge * i.charge;
+                                        ddipole += i.charge * i.pos;
+                                        data.spread(i.pos, i.charge, pending);
+                                    }
+                                    if (t.wasactive) {
+                                        auto &i = old->p[t.index];
+                                        dchargeSquared -= i.charge * i.charge;
+                                        ddipole -= i.charge * i.pos;
+                                        data.spread(i.pos, -i.charge, pending);
+                                    }
+                                }
+                                std::sort(pending.begin(), pending.end());
+                                PMEData::Tstencil merged; // sum overlapping stencils
+                                for (auto &s : pending)
+                                    if (not merged.empty() and merged.back().first==s.first)
+                                        merged.back().second += s.second;
+                                    else
+                                        merged.push_back(s);
+                                pending.swap(merged);
+                                double n = data.Q.size();
+                                if (double(pending.size())*pending.size() > 4*n*std::log2(n)) { // FFT is cheaper
+                                    clear();
+                                    rebuild();
+                                    rebuilt = true;
+                                } else
+                                    dqpsi = data.delta(pending);
+                            }
+                        }
+                        double V = spc.geo.getVolume();
+                        double q2 = data.chargeSquared + dchargeSquared;
+                        Point mu = data.dipole + ddipole;
+                        double u = 2 * pc::pi / V * (data.qpsi + dqpsi) - data.alpha * q2 / std::sqrt(pc::pi);
+                        if (data.const_inf > 0.5)
+                            u += data.const_inf * 2 * pc::pi / ( (2*data.eps_surf+1) * V ) * mu.dot(mu);
+                        return u * data.lB;
+                    }
+
+                    void sync(Energybase *basePtr, Change &change) override {
+                        auto other = dynamic_cast<decltype(this)>(basePtr);
+                        assert(other);
+                        if (other->key==OLD)
+                            old = &(other->spc); // give NEW access to OLD space for optimized updates
+                        if (rebuilt or other->rebuilt or change.all or change.dV)
+                            data = other->data; // copy everything
+                        else if (not other->pending.empty()) { // accept: update old state and copy to trial state
+                            for (auto &s : other->pending)
+                                data.Q[s.first] += s.second;
+                            data.chargeSquared += other->dchargeSquared;
+                            data.dipole += other->ddipole;
+                            data.convolve();
+                            other->data.Q = data.Q;
+                            other->data.psi = data.psi;
+                            other->data.qpsi = data.qpsi;
+                            other->data.chargeSquared = data.chargeSquared;
+                            other->data.dipole = data.dipole;
+                        }
+                        clear();
+                        other->clear();
+                    } //!< Called after a move is rejected/accepted as well as before simulation
+
+                    void to_json(json &j) const override {
+                        j = data;
+                    }
+            };
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+        TEST_CASE("[Faunus] SPME")
+        {
+            using doctest::Approx;
+            typedef Space<Geometry::Chameleon, Particle<Charge,Dipole>> Tspace;
+
+            json j = R"({"epsr": 1.0, "alpha": 0.894427190999916, "epss": 1.0, "order": 8, "spacing": 0.3})"_json;
+            Change all;
+            all.all = true;
+
+            Tspace spc;
+            spc.p.resize(2);
+            spc.geo  = R"( {"type": "cuboid", "length": 10} )"_json;
+            spc.p[0] = R"( {"pos": [0,0,0], "q": 1.0} )"_json;
+            spc.p[1] = R"( {"pos": [1,0,0], "q": -1.0} )"_json;
+            spc.groups.emplace_back(spc.p.begin(), spc.p.end());
+
+            PME<Tspace> pme(j, spc); // compare with self, surface, and reciprocal energies from Ewald
+            CHECK( pme.energy(all) == Approx( (-1.0092530088080642 + 0.0020943951023931952 + 0.21303063979675319)
+                        * pc::lB(1.0) ).epsilon(1e-6) );
+
+            SUBCASE("incremental update") {
+                j["order"] = 4;
+                j["spacing"] = 0.5; // small enough stencils to avoid rebuilding grids
+                Tspace trial, old;
+                trial.geo = old.geo = R"( {"type": "cuboid", "length": 10} )"_json;
+                trial.p.resize(20);
+                for (size_t i=0; i<trial.p.size(); i++) {
+                    trial.p[i].pos = Point( std::fmod(1.7*i, 10), std::fmod(3.1*i, 10), std::fmod(0.9*i, 10) ) - Point(5,5,5);
+                    trial.p[i].charge = (i%2==0) ? 1 : -1;
+                }
+                old.p = trial.p;
+                for (auto v : {&trial, &old}) {
+                    v->groups.emplace_back(v->p.begin(), v->p.begin()+10);
+                    v->groups.emplace_back(v->p.begin()+10, v->p.end());
+                }
+
+                PME<Tspace> pnew(j, trial), pold(j, old);
+                pnew.key = Energybase::NEW;
+                pold.key = Energybase::OLD;
+                pnew.sync(&pold, all);
+
+                auto check = [&](Change &change) {
+                    double du = pnew.energy(change) - pold.energy(change);
+                    PME<Tspace> ref(j, trial);
+                    CHECK( du == Approx( ref.energy(all) - pold.energy(change) ) );
+                    pold.sync(&pnew, change); // accept
+                    old.p = trial.p;
+                    for (size_t k=0; k<trial.groups.size(); k++)
+                        old.groups[k].end() = old.groups[k].begin() + trial.groups[k].size();
+                    CHECK( pold.energy(change) == Approx( ref.energy(all) ) );
+                    CHECK( pnew.energy(change) == Approx( ref.energy(all) ) );
+                };
+
+                Change change; // atoms in two groups
+                change.groups.resize(2);
+                change.groups[0].index = 0;
+                change.groups[0].atoms = {1};
+                change.groups[1].index = 1;
+                change.groups[1].atoms = {0};
+                for (int i : {1, 10}) {
+                    trial.p[i].pos += Point(0.3, -2.2, 0.1);
+                    trial.p[i].charge *= 0.5;
+                }
+                check(change);
+
+                auto &g = trial.groups[1];
+                change.clear(); // deactivate the last two atoms
+                change.dN = true;
+                change.groups.resize(1);
+                change.groups[0].index = 1;
+                change.groups[0].atoms = {8,9};
+                g.deactivate(g.end()-2, g.end());
+                check(change);
+
+                trial.p[3].pos = Point(4.9, -4.9, 0); // rejected move restores the trial state
+                change.groups[0].index = 0;
+                change.groups[0].atoms = {3};
+                change.dN = false;
+                double du = pnew.energy(change) - pold.energy(change);
+                CHECK( du != Approx(0) );
+                trial.p = old.p;
+                pnew.sync(&pold, change);
+                CHECK( pnew.energy(change) == Approx( pold.energy(change) ) );
+            }
+        }
+#endif
+
         template<typename Tspace>
             class Isobaric : public Energybase {
                 private:
@@ -331,6 +1056,8 @@ namespace Faunus {
                             return P*V-(N+1)*std::log(V);
                         } else return 0;
                     }
+                    double interactionRange() const override { return 0; }
+                    double particleEnergy(int, const std::vector<int>&) override { return 0; } // volume only
                     void to_json(json &j) const override {
                         j["P/atm"] = P / 1.0_atm;
                         j["P/mM"] = P / 1.0_mM;
@@ -457,6 +1184,47 @@ namespace Faunus {
                         return u;
                     }
 
+                    /*
+                     * Single pass over the changed particles: `func` is evaluated for the trial
+                     * and old positions together. Volume and particle number changes fall back
+                     * to two separate energy evaluations.
+                     */
+                    double delta(Change &change, Energybase *basePtr) override {
+                        auto other = dynamic_cast<ExternalPotential*>(basePtr);
+                        if (other==nullptr or not change or change.dV or change.all or change.dN)
+                            return Energybase::delta(change, basePtr);
+                        double du=0;
+                        for (auto &d : change.groups) {
+                            auto &g1 = spc.groups.at(d.index);        // trial
+                            auto &g0 = other->spc.groups.at(d.index); // old
+                            if (molids.find(g1.id) == molids.end())
+                                continue;
+                            if (COM) {
+                                Tparticle cm1, cm0;
+                                cm1.pos = g1.cm;
+                                cm0.pos = g0.cm;
+                                du += func(cm1) - func(cm0);
+                            } else if (d.all) {
+                                for (size_t i=0; i<g1.size(); i++)
+                                    du += func( *(g1.begin()+i) ) - func( *(g0.begin()+i) );
+                            } else
+                                for (auto i : d.atoms)
+                                    du += func( *(g1.begin()+i) ) - func( *(g0.begin()+i) );
+                            if (std::isnan(du))
+                                break;
+                        }
+                        return du;
+                    }
+
+                    double interactionRange() const override { return COM ? -1 : 0; }
+
+                    double particleEnergy(int i, const std::vector<int>&) override {
+                        auto it = spc.findGroupContaining( spc.p[i] );
+                        if (it!=spc.groups.end() and molids.find(it->id)!=molids.end())
+                            return func( spc.p[i] );
+                        return 0;
+                    }
+
                     void to_json(json &j) const override {
                         j["molecules"] = _names;
                         j["com"] = COM;
@@ -584,6 +1352,8 @@ namespace Faunus {
                 public:
                     ExternalAkesson(const json &j, Tspace &spc) : base(j,spc) {
                         base::name = "akesson";
+                        base::concurrent = false; // energy() samples rho(z) in the old state
+                        base::undoable = false;
                         base::cite = "doi:10/dhb9mj";
 
                         xjson _j = j; // json variant where items are deleted after access
@@ -626,6 +1396,14 @@ namespace Faunus {
                         return base::energy(change);
                     }
 
+                    double delta(Change &change, Energybase *basePtr) override {
+                        return Energybase::delta(change, basePtr); // energy() samples rho(z) in the old state
+                    }
+
+                    double interactionRange() const override {
+                        return -1; // energy() samples rho(z)
+                    }
+
                     ~ExternalAkesson() {
                         // save only if still updating and if energy type is "OLD",
                         // that is, accepted configurations (not trial)
@@ -766,6 +1544,16 @@ namespace Faunus {
                         return u;
                     } // sum energy in vector of BondData
 
+                    double sum( const BondVector &v, const BondVector &v0, int iparticle=-1 ) const {
+                        assert(v.size()==v0.size());
+                        double du=0;
+                        auto dist = spc.geo.getDistanceFunc();
+                        for (size_t i=0; i<v.size(); i++)
+                            if (iparticle<0 or std::find(v[i]->index.begin(), v[i]->index.end(), iparticle) != v[i]->index.end())
+                                du += v[i]->energy(dist) - v0[i]->energy(dist);
+                        return du;
+                    } // energy change of matching bonds in trial (`v`) and old (`v0`) vectors; -1 matches all
+
                 public:
                     Bonded(const json &j, Tspace &spc) : spc(spc) {
                         name = "bonded";
@@ -813,6 +1601,31 @@ namespace Faunus {
                         }
                         return u;
                     }; // brute force -- refine this!
+
+                    /*
+                     * Bonds in the trial and old states are stored in the same order so
+                     * both energies are evaluated in a single pass over the bond lists.
+                     */
+                    double delta(Change &c, Energybase *basePtr) override {
+                        auto other = dynamic_cast<decltype(this)>(basePtr);
+                        if (other==nullptr or not c or c.all or c.dV or c.dN)
+                            return Energybase::delta(c, basePtr);
+                        double du = sum(inter, other->inter);
+                        for (auto &d : c.groups)
+                            if (d.internal) {
+                                auto it = intra.find(d.index), it0 = other->intra.find(d.index);
+                                if (it==intra.end() or it0==other->intra.end())
+                                    continue;
+                                if (d.all)
+                                    du += sum(it->second, it0->second);
+                                else {
+                                    int offset = std::distance(spc.p.begin(), spc.groups[d.index].begin());
+                                    for (int i : d.atoms)
+                                        du += sum(it->second, it0->second, i+offset);
+                                }
+                            }
+                        return du;
+                    }
             };
 
         /**
@@ -821,26 +1634,43 @@ namespace Faunus {
         template<typename Tspace, typename Tpairpot>
             class Nonbonded : public Energybase {
                 private:
-                    double g2gcnt=0, g2gskip=0;
+                    std::atomic<unsigned long long> g2gcnt{0}, g2gskip{0}; // atomic as `cut()` may run in parallel
                     PairMatrix<double> cutoff2; // matrix w. group-to-group cutoff
 
                 protected:
                     typedef typename Tspace::Tpvec Tpvec;
                     typedef typename Tspace::Tgroup Tgroup;
                     double Rc2_g2g=pc::infty;
-
-                    // control of when OpenMP should be used
-                    bool omp_enable=false;
-                    bool omp_i2all=false;
-                    bool omp_g2g=false;
+                    double rc_pairpot=pc::infty; // distance beyond which the pair potential is zero
+
+                    // control of when the thread pool should be used
+                    bool parallel_i2all=false;
+                    bool parallel_g2g=false;
+                    size_t minwork=10000; // min. number of pair interactions for parallel evaluation
+                    ParallelStats parallelstats;
+
+                    template<class Tfunction>
+                        double parallelSum(bool enabled, size_t n, size_t work, Tfunction f) {
+                            if (enabled) {
+                                if (work>=minwork and threadPool().size()>0)
+                                    return threadPool().sum(n, f, &parallelstats);
+                                parallelstats.serial++;
+                            }
+                            double u=0;
+                            for (size_t i=0; i<n; i++)
+                                u += f(i);
+                            return u;
+                        } //!< Sum of `f(i)` for i in [0:n[; in parallel if `enabled` and `work` is large enough
 
                     void to_json(json &j) const override {
                         j["pairpot"] = pairpot;
-                        if (omp_enable) {
+                        if (parallel_g2g or parallel_i2all) {
                             json _a = json::array();
-                            if (omp_g2g) _a.push_back("g2g");
-                            if (omp_i2all) _a.push_back("i2all");
-                            j["openmp"] = _a;
+                            if (parallel_g2g) _a.push_back("g2g");
+                            if (parallel_i2all) _a.push_back("i2all");
+                            j["parallel"] = _a;
+                            j["minwork"] = minwork;
+                            j["parallel statistics"] = parallelstats;
                         }
                         j["cutoff_g2g"] = json::object();
                         auto &_j = j["cutoff_g2g"];
@@ -848,16 +1678,30 @@ namespace Faunus {
                             for (auto &b : Faunus::molecules<typename Tspace::Tpvec>)
                                 if (a.id()>=b.id())
                                     _j[a.name+" "+b.name] = sqrt( cutoff2(a.id(), b.id()) );
+                        if (g2gcnt>0) {
+                            double cnt = g2gcnt, skip = g2gskip;
+                            auto &_p = j["g2g pruning"] = {
+                                {"pairs", cnt}, {"skipped", skip}, {"skipped fraction", skip/cnt} };
+                            if (std::isfinite(rc_pairpot))
+                                _p["pair cutoff"] = rc_pairpot;
+                        }
                     }
 
+                    /*
+                     * Molecular groups are skipped if either their mass centers are further apart than
+                     * `cutoff_g2g`, or if their bounding spheres (see `Group::radius`) are separated by
+                     * more than the pair potential cutoff so that all particle pairs interact with zero energy.
+                     */
                     template<typename T>
                         inline bool cut(const T &g1, const T &g2) {
-                            g2gcnt++;
+                            g2gcnt.fetch_add(1, std::memory_order_relaxed);
                             if (g1.atomic || g2.atomic)
                                 return false;
-                            if ( spc.geo.sqdist(g1.cm, g2.cm) < cutoff2(g1.id, g2.id) )
+                            double r2 = spc.geo.sqdist(g1.cm, g2.cm);
+                            double rmax = rc_pairpot + g1.radius + g2.radius;
+                            if ( r2 < cutoff2(g1.id, g2.id) && r2 <= rmax*rmax )
                                 return false;
-                            g2gskip++;
+                            g2gskip.fetch_add(1, std::memory_order_relaxed);
                             return true;
                         } //!< true if group<->group interaction can be skipped
 
@@ -867,31 +1711,56 @@ namespace Faunus {
                             return pairpot(a, b, spc.geo.vdist(a.pos, b.pos));
                         }
 
+                    template<typename T>
+                        inline double i2i(const ExclusionList &ex, int i, int j, const T &a, const T &b) {
+                            switch (ex(i,j)) {
+                                case ExclusionList::NONE:
+                                    return i2i(a,b);
+                                case ExclusionList::KEEPELECTROSTATICS:
+                                    return Potential::electrostatic(pairpot, a, b, spc.geo.vdist(a.pos, b.pos));
+                                default:
+                                    return 0;
+                            }
+                        } //!< Energy of atoms `i` and `j` within the same molecule, respecting exclusions
+
+                    double i2group(const Tgroup &g, int i) {
+                        double u=0;
+                        auto &ex = molecules<Tpvec>.at(g.id).exclusions;
+                        auto &a = *(g.begin()+i);
+                        for (int j=0; j<int(g.size()); j++)
+                            if (j!=i)
+                                u += i2i(ex, i, j, a, *(g.begin()+j));
+                        return u;
+                    } //!< Energy of atom `i` (index within group) with the rest of group `g`, respecting exclusions
+
                     /*
                      * Internal energy in group, calculating all with all or, if `index`
                      * is given, only a subset. Index specifies the internal index (starting
-                     * at zero) of changed particles within the group.
+                     * at zero) of changed particles within the group. Atom pairs excluded
+                     * by bonds (see `ExclusionList`) are skipped.
                      */
-                    double g_internal(const Tgroup &g, const std::vector<int> &index=std::vector<int>()) {
+                    virtual double g_internal(const Tgroup &g, const std::vector<int> &index=std::vector<int>()) {
                         using namespace ranges;
                         double u=0;
+                        auto &ex = molecules<Tpvec>.at(g.id).exclusions;
+                        int n = g.size();
                         if (index.empty() and not molecules<Tpvec>.at(g.id).rigid) // assume that all atoms have changed
-                            for ( auto i = g.begin(); i != g.end(); ++i )
-                                for ( auto j=i; ++j != g.end(); )
-                                    u += i2i(*i, *j);
+                            for (int i=0; i<n; i++)
+                                for (int j=i+1; j<n; j++)
+                                    u += i2i(ex, i, j, *(g.begin()+i), *(g.begin()+j));
                         else { // only a subset have changed
-                            auto fixed = view::ints( 0, int(g.size()) )
+                            auto fixed = view::ints( 0, n )
                                 | view::remove_if(
                                         [&index](int i){return std::binary_search(index.begin(), index.end(), i);});
                             for (int i : index) {// moved<->static
                                 for (int j : fixed ) {
-                                    u += i2i( *(g.begin()+i), *(g.begin()+j));
+                                    u += i2i(ex, i, j, *(g.begin()+i), *(g.begin()+j));
                                 }
                             }
                             for (int i : index) // moved<->moved
                                 for (int j : index)
                                     if (j>i)
-                                        u += i2i( *(g.begin()+i), *(g.begin()+j));
+                                        u += i2i(ex, i, j, *(g.begin()+i), *(g.begin()+j));
                         }
                         return u;
                     }
@@ -901,21 +1770,19 @@ namespace Faunus {
                      * and checks (1) if it is already part of Space, or (2)
                      * external to space.
                      */
-                    double i2all(const typename Tspace::Tparticle &i) {
+                    virtual double i2all(const typename Tspace::Tparticle &i) {
                         double u=0;
                         auto it = spc.findGroupContaining(i); // iterator to group
                         if (it!=spc.groups.end()) {    // check if i belongs to group in space
-#pragma omp parallel for reduction (+:u) if (omp_enable and omp_i2all)
-                            for (size_t ig=0; ig<spc.groups.size(); ig++) {
-                                auto &g = spc.groups[ig];
-                                if (&g!=&(*it))        // avoid self-interaction
-                                    if (not cut(g, *it))  // check g2g cut-off
-                                        for (auto &j : g) // loop over particles in other group
-                                            u += i2i(i,j);
-                            }
-                            for (auto &j : *it)        // i with all particles in own group
-                                if (&j!=&i)
-                                    u += i2i(i,j);
+                            u = parallelSum(parallel_i2all, spc.groups.size(), spc.p.size(), [&](size_t ig) {
+                                    double ug=0;
+                                    auto &g = spc.groups[ig];
+                                    if (&g!=&(*it))        // avoid self-interaction
+                                        if (not cut(g, *it))  // check g2g cut-off
+                                            for (auto &j : g) // loop over particles in other group
+                                                ug += i2i(i,j);
+                                    return ug; } );
+                            u += i2group(*it, &i - &(*it->begin())); // i with all particles in own group
                         } else // particle does not belong to any group
                             for (auto &g : spc.groups) // i with all other *active* particles
                                 for (auto &j : g)      // (this will include only active particles)
@@ -961,6 +1828,61 @@ namespace Faunus {
                         return u;
                     }
 
+                    /*
+                     * Energy change of atoms in `g1` (trial) and `g0` (old) with the static group `g2`.
+                     * Each particle in `g2` is loaded once and paired with both the trial and old
+                     * positions. If `index` is empty, all atoms in `g1` are assumed to have changed.
+                     * Group cut-offs are applied in each state as in `i2all()` and `g2g()`.
+                     */
+                    double g2gDelta(const Tgroup &g1, const Tgroup &g0, const Tgroup &g2, const std::vector<int> &index) {
+                        bool skip1 = cut(g1,g2), skip0 = cut(g0,g2);
+                        double du=0;
+                        if (skip1 and skip0)
+                            return du;
+                        auto moved = [&](int i) {
+                            auto &a1 = *(g1.begin()+i), &a0 = *(g0.begin()+i);
+                            for (auto &b : g2) {
+                                if (not skip1) du += i2i(a1,b);
+                                if (not skip0) du -= i2i(a0,b);
+                            }
+                        };
+                        if (index.empty())
+                            for (int i=0; i<int(g1.size()); i++)
+                                moved(i);
+                        else
+                            for (int i : index)
+                                moved(i);
+                        return du;
+                    }
+
+                    /*
+                     * Internal energy change of a group with trial (`g1`) and old (`g0`) positions,
+                     * mirroring `g_internal()`. Unchanged partners are taken from `g1` only.
+                     */
+                    double g_internalDelta(const Tgroup &g1, const Tgroup &g0, const std::vector<int> &index) {
+                        double du=0;
+                        auto &ex = molecules<Tpvec>.at(g1.id).exclusions;
+                        int n = g1.size();
+                        if (index.empty()) {
+                            if (not molecules<Tpvec>.at(g1.id).rigid) // all atoms have changed
+                                for (int i=0; i<n; i++)
+                                    for (int j=i+1; j<n; j++)
+                                        du += i2i(ex, i, j, *(g1.begin()+i), *(g1.begin()+j))
+                                            - i2i(ex, i, j, *(g0.begin()+i), *(g0.begin()+j));
+                            return du;
+                        }
+                        for (int i : index) {
+                            auto &a1 = *(g1.begin()+i), &a0 = *(g0.begin()+i);
+                            for (int j=0; j<n; j++)
+                                if (not std::binary_search(index.begin(), index.end(), j)) { // moved<->static
+                                    auto &b = *(g1.begin()+j);
+                                    du += i2i(ex, i, j, a1, b) - i2i(ex, i, j, a0, b);
+                                } else if (j>i) // moved<->moved
+                                    du += i2i(ex, i, j, a1, *(g1.begin()+j)) - i2i(ex, i, j, a0, *(g0.begin()+j));
+                        }
+                        return du;
+                    }
+
                 public:
                     Tspace& spc;   //!< Space to operate on
                     Tpairpot pairpot; //!< Pair potential
@@ -968,20 +1890,24 @@ namespace Faunus {
                     Nonbonded(const json &j, Tspace &spc) : spc(spc) {
                         name="nonbonded";
                         pairpot = j;
+                        rc_pairpot = std::sqrt( pairpot.cutoff2() );
 
-                        // controls for OpenMP
-                        auto it = j.find("openmp");
+                        // controls for the thread pool; `openmp` is the former name
+                        auto it = j.find("parallel");
+                        if (it == j.end())
+                            it = j.find("openmp");
                         if (it != j.end())
                             if (it->is_array())
-                                if (it->size()>0) {
-                                    omp_enable=true;
-                                    for (const std::string &k : *it)
-                                        if (k=="g2g") omp_g2g=true;
-                                        else if (k=="i2all") omp_i2all=true;
-#ifndef _OPENMP
-                                    std::cerr << "warning: nonbonded requests unavailable OpenMP." << endl;
-#endif
-                                }
+                                for (const std::string &k : *it)
+                                    if (k=="g2g") parallel_g2g=true;
+                                    else if (k=="i2all") parallel_i2all=true;
+                                    else throw std::runtime_error("nonbonded: unknown parallel keyword '" + k + "'");
+                        if ((parallel_g2g or parallel_i2all) and not pairpot.threadsafe())
+                            throw std::runtime_error("nonbonded: 'parallel' requires a thread safe pair potential (not 'custom')");
+                        minwork = j.value("minwork", minwork);
+                        if (j.value("pinthreads", false))
+                            if (not threadPool().pin())
+                                std::cerr << "warning: nonbonded could not pin threads to cores." << endl;
 
                         // disable all group-to-group cutoffs by setting infinity
                         for (auto &i : Faunus::molecules<typename Tspace::Tpvec>)
@@ -1029,33 +1955,46 @@ namespace Faunus {
                             }
                     }
 
+                    double interactionRange() const override {
+                        return pairpot.threadsafe() ? rc_pairpot : -1; // `particleEnergy()` runs concurrently
+                    }
+
+                    double particleEnergy(int i, const std::vector<int> &neighbors) override {
+                        double u=0;
+                        auto &a = spc.p[i];
+                        for (int j : neighbors)
+                            if (j!=i)
+                                u += i2i(a, spc.p[j]);
+                        return u;
+                    } //!< Energy of particle `i` with `neighbors`, ignoring exclusions and `cutoff_g2g`
+
                     double energy(Change &change) override {
                         using namespace ranges;
                         double u=0;
 
                         if (change) {
 
+                            size_t npairs = spc.p.size() * spc.p.size() / 2;
+
                             if (change.dV) {
-#pragma omp parallel for reduction (+:u) schedule (dynamic) if (omp_enable and omp_g2g)  
-                                for ( auto i = spc.groups.begin(); i < spc.groups.end(); ++i ) {
-                                    for ( auto j=i; ++j != spc.groups.end(); )
-                                        u += g2g( *i, *j );
-                                    if (i->atomic)
-                                        u += g_internal(*i);
-                                }
-                                return u;
+                                return parallelSum(parallel_g2g, spc.groups.size(), npairs, [&](size_t i) {
+                                        double ug=0;
+                                        for ( auto j=i+1; j<spc.groups.size(); j++ )
+                                            ug += g2g( spc.groups[i], spc.groups[j] );
+                                        if (spc.groups[i].atomic)
+                                            ug += g_internal(spc.groups[i]);
+                                        return ug; } );
                             }
 
                             // did everything change?
                             if (change.all) {
-#pragma omp parallel for reduction (+:u) schedule (dynamic) if (omp_enable and omp_g2g)
-                                for ( auto i = spc.groups.begin(); i < spc.groups.end(); ++i ) {
-                                    for ( auto j=i; ++j != spc.groups.end(); )
-                                        u += g2g( *i, *j );
-                                    u += g_internal(*i);
-                                }
                                 // more todo here...
-                                return u;
+                                return parallelSum(parallel_g2g, spc.groups.size(), npairs, [&](size_t i) {
+                                        double ug=0;
+                                        for ( auto j=i+1; j<spc.groups.size(); j++ )
+                                            ug += g2g( spc.groups[i], spc.groups[j] );
+                                        ug += g_internal(spc.groups[i]);
+                                        return ug; } );
                             }
 
                             // if exactly ONE molecule is changed
@@ -1069,13 +2008,10 @@ namespace Faunus {
 
                                 // more atoms moved
                                 auto& g1 = spc.groups.at(d.index);
-                                //for (auto &g2 : spc.groups)
-#pragma omp parallel for reduction (+:u) if (omp_enable and omp_g2g)
-                                for (size_t i=0; i<spc.groups.size(); i++) {
-                                    auto &g2 = spc.groups[i];
-                                    if (&g1 != &g2)
-                                        u += g2g(g1, g2, d.atoms);
-                                }
+                                size_t nmoved = d.atoms.empty() ? g1.size() : d.atoms.size();
+                                u = parallelSum(parallel_g2g, spc.groups.size(), nmoved*spc.p.size(), [&](size_t i) {
+                                        auto &g2 = spc.groups[i];
+                                        return (&g1 != &g2) ? g2g(g1, g2, d.atoms) : 0.0; } );
                                 if (d.internal)
                                     u += g_internal(g1, d.atoms);
                                 return u;
@@ -1140,14 +2076,221 @@ namespace Faunus {
                         return u;
                     }
 
+                    /*
+                     * Fused energy change when exactly one molecule is changed at constant
+                     * volume and particle number; all other changes fall back to two
+                     * separate energy evaluations.
+                     */
+                    double delta(Change &change, Energybase *basePtr) override {
+                        auto other = dynamic_cast<decltype(this)>(basePtr);
+                        if (other==nullptr or not change or change.dV or change.all or change.dN or change.groups.size()!=1)
+                            return Energybase::delta(change, basePtr);
+                        auto &d = change.groups[0];
+                        auto &g1 = spc.groups.at(d.index);        // trial
+                        auto &g0 = other->spc.groups.at(d.index); // old
+                        assert(g1.size()==g0.size());
+                        size_t nmoved = d.atoms.empty() ? g1.size() : d.atoms.size();
+                        double du = parallelSum(parallel_g2g, spc.groups.size(), 2*nmoved*spc.p.size(), [&](size_t i) {
+                                return (int(i)!=d.index) ? g2gDelta(g1, g0, spc.groups[i], d.atoms) : 0.0; } );
+                        if (d.atoms.size()==1 or d.internal) // single atoms always interact with own group (see `i2all()`)
+                            du += g_internalDelta(g1, g0, d.atoms);
+                        return du;
+                    }
+
             }; //!< Nonbonded, pair-wise additive energy term
 
-        template<typename Tspace, typename Tpairpot>
+#ifdef DOCTEST_LIBRARY_INCLUDED
+        TEST_CASE("[Faunus] Nonbonded - delta")
+        {
+            typedef Space<Geometry::Chameleon, Particle<Charge>> Tspace;
+            typedef Potential::CoulombGalore Tpairpot;
+
+            SaltFixture<Tspace> salt( R"( {"type": "cuboid", "length": 20} )"_json );
+            salt.addSalt(40); // atomic salt and molecular dimers
+            salt.addDimers(20);
+            auto &spc = salt.spc;
+            auto &slump = salt.slump;
+            Tspace old;
+
+            Change all;
+            all.all = true;
+            spc.update(all); // bounding radii
+            old.sync(spc, all);
+
+            // bounding spheres only, then also mass center cut-offs applied to single atom moves
+            for (auto &input : {
+                    R"({"coulomb": {"type": "plain", "epsr": 80, "cutoff": 5}})",
+                    R"({"coulomb": {"type": "plain", "epsr": 80, "cutoff": 5}, "cutoff_g2g": 6})",
+                    R"({"coulomb": {"type": "plain", "epsr": 80, "cutoff": 5}, "cutoff_g2g": {"default": 8, "dimer dimer": 3}})" }) {
+                json j = json::parse(input);
+                bool exact = j.count("cutoff_g2g")==0; // pruning leaves the total energy unaffected
+                Nonbonded<Tspace, Tpairpot> pot1(j, spc), pot0(j, old);
+
+                auto check = [&](Change &change) {
+                    spc.update(change);
+                    double du = pot1.delta(change, &pot0);
+                    CHECK( du == doctest::Approx( pot1.energy(change) - pot0.energy(change) ) );
+                    if (exact)
+                        CHECK( du == doctest::Approx( pot1.energy(all) - pot0.energy(all) ) );
+                    old.sync(spc, change); // accept
+                };
+                auto displacement = [&]() -> Point { return (Point(slump(), slump(), slump()) - Point(0.5,0.5,0.5)) * 6; };
+
+                for (int n=0; n<50; n++) {
+                    Change change;
+                    change.groups.resize(1);
+                    auto &d = change.groups[0];
+
+                    // single salt particle
+                    d.index = 0;
+                    d.atoms = { slump.range(0, int(spc.groups[0].size())-1) };
+                    auto &a = *(spc.groups[0].begin() + d.atoms[0]);
+                    a.pos += displacement();
+                    spc.geo.boundary(a.pos);
+                    check(change);
+
+                    // single atom in a molecule
+                    d.index = slump.range(1, int(spc.groups.size())-1);
+                    d.atoms = { slump.range(0, 1) };
+                    auto &b = *(spc.groups[d.index].begin() + d.atoms[0]);
+                    b.pos += displacement() * 0.1;
+                    spc.geo.boundary(b.pos);
+                    check(change);
+
+                    // whole molecule
+                    d.index = slump.range(1, int(spc.groups.size())-1);
+                    d.atoms.clear();
+                    d.all = true;
+                    spc.groups[d.index].translate( displacement(), spc.geo.getBoundaryFunc() );
+                    check(change);
+                }
+
+                // deletion of a salt particle
+                Change change;
+                change.dN = true;
+                change.groups.resize(1);
+                auto &d = change.groups[0];
+                auto &g = spc.groups[0];
+                d.index = 0;
+                d.internal = true;
+                d.dNatomic = true;
+                d.atoms = { int(g.size())-1 };
+                g.deactivate( g.end()-1, g.end() );
+                check(change);
+                CHECK( old.groups[0].size()==g.size() );
+            }
+        }
+#endif
+
+        /**
+         * @brief Dense storage of group-to-group energies for `NonbondedCached`
+         *
+         * Memory scales as the number of groups squared; only the upper
+         * triangle, `i<j`, is used.
+         */
+        class EnergyMatrixDense {
+            private:
+                Eigen::MatrixXf m;
+            public:
+                static constexpr bool threadsafe=true; //!< Can distinct pairs be set concurrently?
+                std::string name() const { return "dense"; }
+                void resize(int n) { m.setZero(n,n); } //!< Resize and zero all energies
+                float operator()(int i, int j) const { return m(i,j); } //!< Energy of groups `i<j`
+                void set(int i, int j, float u) { m(i,j) = u; } //!< Set energy of groups `i<j`
+                size_t size() const { return m.rows()*(m.rows()-1)/2; } //!< Number of stored pairs
+        };
+
+        /**
+         * @brief Sparse storage of group-to-group energies for `NonbondedCached`
+         *
+         * Only non-zero energies are stored in sorted adjacency lists
+         * for each group so that memory scales as the number of
+         * interacting group pairs. Look-up is logarithmic in the
+         * number of neighbors.
+         */
+        class EnergyMatrixSparse {
+            private:
+                typedef std::pair<int,float> Tentry; // neighbor group index and energy
+                std::vector<std::vector<Tentry>> adj; // sorted non-zero energies for each group (symmetric)
+
+                static auto find(std::vector<Tentry> &v, int j) {
+                    return std::lower_bound(v.begin(), v.end(), j, [](const Tentry &a, int j){ return a.first<j; });
+                }
+
+                void assign(int i, int j, float u) {
+                    auto &v = adj[i];
+                    auto it = find(v, j);
+                    if (it!=v.end() && it->first==j) {
+                        if (u==0)
+                            v.erase(it);
+                        else
+                            it->second = u;
+                    } else if (u!=0)
+                        v.insert(it, {j,u});
+                }
+
+            public:
+                static constexpr bool threadsafe=false; //!< Can distinct pairs be set concurrently?
+                std::string name() const { return "sparse"; }
+                void resize(int n) { adj.assign(n, {}); } //!< Resize and zero all energies
+
+                float operator()(int i, int j) const {
+                    auto &v = adj[i];
+                    auto it = std::lower_bound(v.begin(), v.end(), j, [](const Tentry &a, int j){ return a.first<j; });
+                    return (it!=v.end() && it->first==j) ? it->second : 0;
+                } //!< Energy of groups `i` and `j`
+
+                void set(int i, int j, float u) {
+                    assign(i,j,u);
+                    assign(j,i,u);
+                } //!< Set energy of groups `i` and `j`; zero removes the pair
+
+                size_t size() const {
+                    size_t n=0;
+                    for (auto &v : adj)
+                        n += v.size();
+                    return n/2;
+                } //!< Number of stored (non-zero) pairs
+        };
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+        TEST_CASE("[Faunus] EnergyMatrixSparse")
+        {
+            EnergyMatrixSparse m;
+            m.resize(4);
+            CHECK( m.size()==0 );
+            m.set(0, 3, 1.5);
+            m.set(0, 1, -2);
+            m.set(2, 3, 0); // zeros are not stored
+            CHECK( m.size()==2 );
+            CHECK( m(0,3)==1.5f );
+            CHECK( m(3,0)==1.5f );
+            CHECK( m(1,0)==-2.0f );
+            CHECK( m(2,3)==0 );
+            m.set(3, 0, 0.5);
+            CHECK( m(0,3)==0.5f );
+            m.set(0, 1, 0);
+            CHECK( m(0,1)==0 );
+            CHECK( m.size()==1 );
+        }
+#endif
+
+        /**
+         * @brief Nonbonded energy with cached group-to-group energies (energy matrix)
+         *
+         * The trial state updates cached energies of moved groups and records
+         * which entries changed so that only these are copied upon `sync()`.
+         * The storage, `Tmatrix`, is either `EnergyMatrixDense` or `EnergyMatrixSparse`;
+         * the latter is suited for many groups with a finite interaction range.
+         */
+        template<typename Tspace, typename Tpairpot, typename Tmatrix=EnergyMatrixDense>
             class NonbondedCached : public Nonbonded<Tspace,Tpairpot> {
                 private:
                     typedef Nonbonded<Tspace,Tpairpot> base;
                     typedef typename Tspace::Tgroup Tgroup;
-                    Eigen::MatrixXf cache;
+                    Tmatrix cache;
+                    std::vector<std::pair<int,int>> changed; // cache entries modified since last sync
+                    bool track=true; // record modified entries in `changed`?
                     Tspace &spc;
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
@@ -1164,20 +2307,35 @@ namespace Faunus {
                                     for (auto &j : g2)
                                         u += base::i2i(i,j);
                             }
-                            cache(i,j) = u;
+                            if (float(u) != cache(i,j)) {
+                                cache.set(i, j, u);
+                                if (track)
+                                    changed.push_back({i,j});
+                            }
                         }
                         return cache(i,j);                     // return (cached) value
                     }
 
+                    void to_json(json &j) const override {
+                        base::to_json(j);
+                        j["cache"] = cache.name();
+                        j["cached pairs"] = cache.size();
+                    }
+
                 public:
                     NonbondedCached(const json &j, Tspace &spc) : base(j,spc), spc(spc) {
                         base::name += "EM";
+                        base::undoable = false; // cache is updated via `sync()`
                         init();
                     }
 
+                    double interactionRange() const override {
+                        return -1; // cache is updated in `energy()`
+                    }
+
                     void init() override {
-                        cache.resize( spc.groups.size(), spc.groups.size() );
-                        cache.setZero();
+                        cache.resize( spc.groups.size() );
+                        changed.clear();
                         for ( auto i = base::spc.groups.begin(); i < base::spc.groups.end(); ++i ) {
                             for ( auto j=i; ++j != base::spc.groups.end(); ) {
                                 int k = &(*i) - &base::spc.groups.front();
@@ -1190,7 +2348,7 @@ namespace Faunus {
                                         for (auto &l : *j)
                                             u += base::i2i(k,l);
                                 }
-                                cache(k,l) = u;
+                                cache.set(k,l,u);
                             }
                         }
                     } //!< Cache pair interactions in matrix
@@ -1200,14 +2358,16 @@ namespace Faunus {
                         double u=0;
 
                         if (change) {
+                            track = not (change.all || change.dV); // everything is copied upon sync
 
                             if (change.all || change.dV) {
-#pragma omp parallel for reduction (+:u) schedule (dynamic) if (this->omp_enable)
-                                for ( auto i = base::spc.groups.begin(); i < base::spc.groups.end(); ++i ) {
-                                    for ( auto j=i; ++j != base::spc.groups.end(); )
-                                        u += g2g( *i, *j );
-                                }
-                                return u;
+                                auto &groups = base::spc.groups;
+                                size_t npairs = base::spc.p.size() * base::spc.p.size() / 2;
+                                return base::parallelSum(this->parallel_g2g and Tmatrix::threadsafe, groups.size(), npairs, [&](size_t i) {
+                                        double ug=0;
+                                        for ( auto j=i+1; j<groups.size(); j++ )
+                                            ug += g2g( groups[i], groups[j] );
+                                        return ug; } );
                             }
 
                             // if exactly ONE molecule is changed
@@ -1242,20 +2402,562 @@ namespace Faunus {
                         return u;
                     }
 
+                    double delta(Change &change, Energybase *basePtr) override {
+                        return Energybase::delta(change, basePtr); // energy() updates internal state
+                    }
+
                     void sync(Energybase *basePtr, Change &change) override {
                         auto other = dynamic_cast<decltype(this)>(basePtr);
                         assert(other);
                         if (change.all || change.dV)
-                            cache.triangularView<Eigen::StrictlyUpper>() = (other->cache).template triangularView<Eigen::StrictlyUpper>();
+                            cache = other->cache;
                         else
+                            for (auto v : {&changed, &other->changed})
+                                for (auto &p : *v)
+                                    cache.set(p.first, p.second, other->cache(p.first, p.second));
+                        changed.clear();
+                        other->changed.clear();
+                    } //!< Copy modified energies from other
+            }; //!< Nonbonded with cached energies (Energy Matrix)
+
+        /**
+         * @brief Cell list neighbor search for `NonbondedNeighbors`
+         *
+         * Active particles are binned in a periodic cell list with cells
+         * no smaller than the pair-potential cutoff so that all interaction
+         * partners of a particle are found in the 26+1 surrounding cells.
+         * The list is updated incrementally using `Change` objects and only
+         * touched particles are re-binned.
+         */
+        template<class Tspace>
+            class PolicyCellList {
+                private:
+                    Tspace &spc;
+                    CellList<Eigen::Vector3i> cells;
+
+                public:
+                    const std::string name = "celllist";
+                    double cutoff; //!< Minimum cell side length (angstrom)
+
+                    PolicyCellList(Tspace &spc, const json &j) : spc(spc), cutoff(j.at("cutoff").get<double>()) {}
+
+                    void init() {
+                        Change change;
+                        change.all = true;
+                        cells.resize( spc.geo.getLength(), cutoff );
+                        cells.sync(spc, change);
+                    } //!< Rebuild cell list from scratch
+
+                    void update(const Change &change) {
+                        cells.sync(spc, change);
+                    } //!< Update cell list for particles touched by `change`
+
+                    void sync(const PolicyCellList&, const Change &change) {
+                        cells.sync(spc, change);
+                    } //!< Update cell list after `spc` has been synched
+
+                    template<class Tfunction>
+                        void forEachNeighbor(int i, Tfunction f) const {
+                            cells.forEachNeighbor( cells.p2i( spc.p[i].pos ), [&](int j) {
+                                    if (j!=i)
+                                        f(j);
+                                    } );
+                        } //!< Call `f(j)` for all active particles `j` near particle `i`
+
+                    void to_json(json &j) const {
+                        j["cutoff"] = cutoff;
+                        j["cells"] = { cells.KLM[0]+1, cells.KLM[1]+1, cells.KLM[2]+1 };
+                    }
+            };
+
+        /**
+         * @brief Verlet list neighbor search for `NonbondedNeighbors`
+         *
+         * Each active particle holds a list of all active particles within
+         * `cutoff+skin` at the time of the last build. The lists remain valid until
+         * a particle has moved more than `skin/2` from its position at
+         * the last build, which is checked for touched particles only. Rebuilding
+         * uses a cell list if the box allows for at least three cells in each
+         * direction. Volume moves and insertions/deletions always trigger a rebuild.
+         */
+        template<class Tspace>
+            class PolicyVerletList {
+                private:
+                    Tspace &spc;
+                    CellList<Eigen::Vector3i> cells;
+                    std::vector<int> list;     // neighbor index of all particles, stored consecutively
+                    std::vector<int> offset;   // neighbors of `i` are found in `list[offset[i]:offset[i+1]]`
+                    std::vector<Point> origin; // particle positions at last build
+                    std::vector<bool> active;  // active particles at last build
+                    unsigned int generation=0; // incremented at each build
+                    double cnt=0, builds=0;    // number of updates and builds
+
+                    bool moved(int i) const {
+                        return spc.geo.sqdist( spc.p[i].pos, origin[i] ) > 0.25*skin*skin;
+                    } //!< True if `i` has moved more than half the skin since last build
+
+                    bool valid(const Change &change) const {
+                        if (change.all || change.dV || change.dN || origin.size()!=spc.p.size())
+                            return false;
+                        for (auto &d : change.groups) {
+                            auto &g = spc.groups[d.index];
+                            int first = g.begin() - spc.p.begin();
+                            if (d.all || d.atoms.empty()) {
+                                for (int i=first; i<first+int(g.capacity()); i++)
+                                    if (active[i] != (i<first+int(g.size())) || (active[i] && moved(i)))
+                                        return false; // e.g. Widom ghosts are (de)activated without `dN`
+                            } else
+                                for (int i : d.atoms)
+                                    if (moved(first+i))
+                                        return false;
+                        }
+                        return true;
+                    } //!< True if the lists are still valid for particles touched by `change` (incl. activation)
+
+                    template<class Tfunction>
+                        void forEachCandidate(int i, Tfunction f) {
+                            if (cells.size()>0)
+                                cells.forEachNeighbor( cells.p2i( spc.p[i].pos ), f );
+                            else
+                                for (auto &g : spc.groups)
+                                    for (auto it=g.begin(); it!=g.end(); ++it)
+                                        f( it - spc.p.begin() );
+                        } //!< Call `f(j)` for all active particles, `j`, that could be within `cutoff+skin` of `i`
+
+                public:
+                    const std::string name = "verlet";
+                    double cutoff; //!< Pair-potential cutoff (angstrom)
+                    double skin;   //!< Skin distance (angstrom)
+
+                    PolicyVerletList(Tspace &spc, const json &j) : spc(spc) {
+                        cutoff = j.at("cutoff").get<double>();
+                        skin = j.value("skin", 2.0);
+                        if (skin<=0)
+                            throw std::runtime_error("verlet list skin must be positive");
+                    }
+
+                    void init() {
+                        Point box = spc.geo.getLength();
+                        double rlist = cutoff + skin;
+                        if ( (box/rlist).minCoeff()>=3 ) {
+                            Change change;
+                            change.all = true;
+                            cells.resize( box, rlist );
+                            cells.sync(spc, change);
+                        } else
+                            cells = CellList<Eigen::Vector3i>(); // too small box: check all pairs
+
+                        list.clear();
+                        offset.assign( spc.p.size()+1, 0 );
+                        origin.resize( spc.p.size() );
+                        active.assign( spc.p.size(), false );
+                        for (auto &g : spc.groups)
+                            for (auto it=g.begin(); it!=g.end(); ++it)
+                                active[ it - spc.p.begin() ] = true;
+                        for (size_t i=0; i<spc.p.size(); i++) {
+                            origin[i] = spc.p[i].pos;
+                            if (active[i])
+                                forEachCandidate(i, [&](int j) {
+                                        if (j!=int(i))
+                                            if ( spc.geo.sqdist(spc.p[i].pos, spc.p[j].pos) < rlist*rlist )
+                                                list.push_back(j);
+                                        } );
+                            offset[i+1] = list.size();
+                        }
+                        generation++;
+                        builds++;
+                    } //!< Rebuild all neighbor lists
+
+                    void update(const Change &change) {
+                        cnt++;
+                        if (not valid(change))
+                            init();
+                    } //!< Rebuild lists if any touched particle has moved more than half the skin
+
+                    void sync(const PolicyVerletList &other, const Change &change) {
+                        if (generation != other.generation || change.all || change.dV || change.dN) {
+                            list = other.list;
+                            offset = other.offset;
+                            origin = other.origin;
+                            active = other.active;
+                            generation = other.generation;
+                        }
+                    } //!< Adopt neighbor lists from other if it has been rebuilt
+
+                    template<class Tfunction>
+                        void forEachNeighbor(int i, Tfunction f) const {
+                            for (auto j = list.begin()+offset[i], end = list.begin()+offset[i+1]; j!=end; ++j)
+                                f(*j);
+                        } //!< Call `f(j)` for all active particles `j` near particle `i`
+
+                    void to_json(json &j) const {
+                        j["cutoff"] = cutoff;
+                        j["skin"] = skin;
+                        if (cnt>0)
+                            j["rebuild ratio"] = builds / cnt;
+                        if (not origin.empty())
+                            j["avg neighbors"] = double(list.size()) / origin.size();
+                    }
+            };
+
+        /**
+         * @brief Nonbonded energy using neighbor search
+         *
+         * This visits only particles found by a neighbor search policy,
+         * `Tsearch`, when calculating the energy of moved particles and is
+         * intended for pair potentials with a finite `cutoff` beyond which
+         * the energy is exactly zero. The mass center cutoff, `cutoff_g2g`,
+         * is ignored for these particle based moves while volume moves and
+         * insertions/deletions fall back to `Nonbonded`.
+         */
+        template<typename Tspace, typename Tpairpot, typename Tsearch=PolicyCellList<Tspace>>
+            class NonbondedNeighbors : public Nonbonded<Tspace,Tpairpot> {
+                private:
+                    typedef Nonbonded<Tspace,Tpairpot> base;
+                    std::vector<int> groupindex; // group index of each particle in `spc.p`
+                    std::vector<bool> moved;     // true for moved groups (work buffer)
+                    Tsearch search;
+                    size_t trigger;              // index in `spc.changeTriggers`
+
+                    template<class Tfilter>
+                        double i2neighbors(int i, Tfilter filter) {
+                            double u=0;
+                            auto &a = base::spc.p[i];
+                            search.forEachNeighbor(i, [&](int j) {
+                                    if (filter(j))
+                                        u += base::i2i(a, base::spc.p[j]);
+                                    });
+                            return u;
+                        } //!< Energy of particle `i` with all neighbors, `j`, for which `filter(j)` is true
+
+                    void to_json(json &j) const override {
+                        base::to_json(j);
+                        search.to_json(j);
+                    }
+
+                public:
+                    NonbondedNeighbors(const json &j, Tspace &spc) : base(j,spc), search(spc,j) {
+                        base::name += "-" + search.name;
+                        trigger = spc.changeTriggers.size();
+                        spc.changeTriggers.push_back( [this](Tspace&, const Change &change) {
+                                search.update(change); } ); // also called by `Space::undo()`
+                        double rc2 = base::pairpot.cutoff2();
+                        if (std::isinf(rc2))
+                            std::cerr << "warning: " << base::name << ": pair potential has no cutoff;"
+                                " interactions beyond " << search.cutoff << " angstrom are ignored." << endl;
+                        else if (search.cutoff*search.cutoff < rc2)
+                            throw std::runtime_error(base::name + ": cutoff is shorter than the pair potential cutoff of "
+                                    + std::to_string(std::sqrt(rc2)) + " angstrom");
+                        init();
+                    }
+
+                    ~NonbondedNeighbors() {
+                        base::spc.changeTriggers.at(trigger) = [](Tspace&, const Change&) {};
+                    } // space may outlive this
+
+                    void init() override {
+                        auto &spc = base::spc;
+                        groupindex.resize( spc.p.size() );
+                        for (size_t k=0; k<spc.groups.size(); k++) {
+                            auto &g = spc.groups[k];
+                            std::fill( groupindex.begin() + (g.begin()-spc.p.begin()),
+                                    groupindex.begin() + (g.trueend()-spc.p.begin()), int(k) );
+                        }
+                        moved.assign( spc.groups.size(), false );
+                        search.init();
+                    }
+
+                    double energy(Change &change) override {
+                        double u=0;
+                        if (change) {
+                            if (change.dV || change.all || change.dN)
+                                return base::energy(change);
+
+                            auto &spc = base::spc;
+
+                            // if exactly ONE molecule is changed
+                            if (change.groups.size()==1) {
+                                auto &d = change.groups[0];
+                                auto &g1 = spc.groups.at(d.index);
+                                int offset = g1.begin() - spc.p.begin();
+
+                                // exactly one atom has moved
+                                if (d.atoms.size()==1) {
+                                    auto &ex = molecules<typename Tspace::Tpvec>.at(g1.id).exclusions;
+                                    if (ex.empty())
+                                        return i2neighbors(offset+d.atoms[0], [](int){ return true; });
+                                    auto &a = spc.p[offset+d.atoms[0]];
+                                    search.forEachNeighbor(offset+d.atoms[0], [&](int j) {
+                                            if (groupindex[j]==d.index) // same molecule: respect exclusions
+                                                u += base::i2i(ex, d.atoms[0], j-offset, a, spc.p[j]);
+                                            else
+                                                u += base::i2i(a, spc.p[j]);
+                                            });
+                                    return u;
+                                }
+
+                                // more atoms moved
+                                auto other = [&](int j){ return groupindex[j]!=d.index; };
+                                if (d.atoms.empty())
+                                    for (int i=offset; i<offset+int(g1.size()); i++)
+                                        u += i2neighbors(i, other);
+                                else
+                                    for (int i : d.atoms)
+                                        u += i2neighbors(offset+i, other);
+                                if (d.internal)
+                                    u += base::g_internal(g1, d.atoms);
+                                return u;
+                            }
+
+                            // several molecules moved: moved<->static and moved<->moved (counted once)
+                            for (auto &d : change.groups)
+                                moved[d.index] = true;
                             for (auto &d : change.groups) {
-                                for (int i=0; i<d.index; i++)
-                                    cache(i,d.index) = other->cache(i,d.index);
-                                for (size_t i=d.index+1; i<base::spc.groups.size(); i++)
-                                    cache(d.index,i) = other->cache(d.index,i);
+                                auto &g1 = spc.groups[d.index];
+                                int offset = g1.begin() - spc.p.begin();
+                                for (int i=offset; i<offset+int(g1.size()); i++)
+                                    u += i2neighbors(i, [&](int j){
+                                            int k = groupindex[j];
+                                            return k!=d.index && (!moved[k] || k>d.index); });
                             }
-                    } //!< Copy energy matrix from other
-            }; //!< Nonbonded with cached energies (Energy Matrix)
+                            for (auto &d : change.groups)
+                                moved[d.index] = false;
+                        }
+                        return u;
+                    }
+
+                    double delta(Change &change, Energybase *basePtr) override {
+                        return Energybase::delta(change, basePtr); // neighbour search beats the fused group loops
+                    }
+
+                    void sync(Energybase *basePtr, Change &change) override {
+                        auto other = dynamic_cast<decltype(this)>(basePtr);
+                        assert(other);
+                        search.sync(other->search, change); // space has already been synched
+                    } //!< Update neighbor search to match the synched particles
+            }; //!< Nonbonded using neighbor search (cell or Verlet lists)
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+        TEST_CASE("[Faunus] NonbondedNeighbors - Verlet list")
+        {
+            typedef Space<Geometry::Chameleon, Particle<Charge>> Tspace;
+            typedef Potential::CoulombGalore Tpairpot;
+
+            SaltFixture<Tspace> salt( R"( {"type": "cuboid", "length": 20} )"_json );
+            salt.addSalt(200);
+            auto &spc = salt.spc;
+            auto &slump = salt.slump;
+
+            json j = R"({ "cutoff": 5, "skin": 1,
+                "coulomb": {"type": "plain", "epsr": 80, "cutoff": 5} })"_json;
+            NonbondedNeighbors<Tspace, Tpairpot, PolicyVerletList<Tspace>> verlet(j, spc);
+            Nonbonded<Tspace, Tpairpot> plain(j, spc);
+
+            int calls=0; // number of list updates via `Space::update()`
+            auto rebuilds = [&]() {
+                return std::lround( json(verlet)[verlet.name]["rebuild ratio"].get<double>() * calls ) - 1;
+            }; // number of list builds after the one at construction
+
+            Change change; // single atom move
+            change.groups.resize(1);
+            change.groups[0].index = 0;
+            change.groups[0].atoms = {0};
+            auto compare = [&](int i) {
+                change.groups[0].atoms[0] = i;
+                spc.update(change);
+                calls++;
+                CHECK( verlet.energy(change) == doctest::Approx(plain.energy(change)) );
+            };
+            auto translate = [&](int i, const Point &dp) {
+                spc.p[i].pos += dp;
+                spc.geo.boundary(spc.p[i].pos);
+                compare(i);
+            };
+
+            for (int i=0; i<int(spc.p.size()); i++)
+                compare(i);
+            CHECK( rebuilds()==0 );
+
+            // less than half the skin: lists are kept
+            translate(0, {0.4, 0, 0});
+            translate(1, {0, -0.4, 0});
+            CHECK( rebuilds()==0 );
+
+            // more than half the skin in total, then more than the full skin: lists are rebuilt
+            translate(1, {0, -0.2, 0});
+            CHECK( rebuilds()==1 );
+            translate(0, {2.0, 0, 0});
+            CHECK( rebuilds()==2 );
+
+            // random walk with all atoms checked at the end for stale lists
+            for (int n=0; n<1000; n++)
+                translate( slump.range(0, int(spc.p.size())-1), (Point(slump(), slump(), slump()) - Point(0.5,0.5,0.5)) * 0.8 );
+            for (int i=0; i<int(spc.p.size()); i++)
+                compare(i);
+            CHECK( rebuilds()>2 );
+
+            Change all;
+            all.all = true;
+            CHECK( verlet.energy(all) == doctest::Approx(plain.energy(all)) );
+        }
+#endif
+
+        /**
+         * @brief Copy pair potential parameters into a vectorized kernel
+         *
+         * Overloads exist for all potentials supported by `SIMD::PairKernel`
+         * and combined potentials are handled by setting up both parts.
+         */
+        inline void setKernel(SIMD::PairKernel &k, const Potential::Coulomb &pot) {
+            k.coulomb = SIMD::PairKernel::PLAIN;
+            k.lB = pot.lB;
+        }
+
+        inline void setKernel(SIMD::PairKernel &k, const Potential::CoulombGalore &pot) {
+            k.coulomb = SIMD::PairKernel::SPLINE;
+            k.lB = pot.bjerrumLength();
+            k.rc2 = pot.cutoff() * pot.cutoff();
+            k.rc1i = 1 / pot.cutoff();
+            k.spline = pot.splitting();
+        }
+
+        template<class Tparticle>
+            void setKernel(SIMD::PairKernel &k, const Potential::LennardJones<Tparticle> &pot,
+                    SIMD::PairKernel::ShortRanged type=SIMD::PairKernel::LJ) {
+                auto &m = pot.mixing();
+                k.shortranged = type;
+                k.ntypes = atoms.size();
+                k.s2.resize(k.ntypes * k.ntypes);
+                k.eps.resize(k.ntypes * k.ntypes);
+                for (int i=0; i<k.ntypes; i++)
+                    for (int j=0; j<k.ntypes; j++) {
+                        k.s2[i*k.ntypes+j] = m.s2(i,j);
+                        k.eps[i*k.ntypes+j] = m.eps(i,j);
+                    }
+            }
+
+        template<class Tparticle>
+            void setKernel(SIMD::PairKernel &k, const Potential::WeeksChandlerAndersen<Tparticle> &pot) {
+                setKernel(k, static_cast<const Potential::LennardJones<Tparticle>&>(pot), SIMD::PairKernel::WCA);
+            }
+
+        template<class Tparticle>
+            void setKernel(SIMD::PairKernel &k, const Potential::HardSphere<Tparticle> &pot) {
+                k.shortranged = SIMD::PairKernel::HARDSPHERE;
+                k.ntypes = atoms.size();
+                k.s2.resize(k.ntypes * k.ntypes);
+                for (int i=0; i<k.ntypes; i++)
+                    for (int j=0; j<k.ntypes; j++)
+                        k.s2[i*k.ntypes+j] = pot.contact2()(i,j);
+            }
+
+        template<class T1, class T2>
+            void setKernel(SIMD::PairKernel &k, const Potential::CombinedPairPotential<T1,T2> &pot) {
+                setKernel(k, pot.first);
+                setKernel(k, pot.second);
+            }
+
+        /**
+         * @brief Nonbonded energy using explicitly vectorized pair kernels
+         *
+         * Particle-to-group and group-to-group energies are evaluated by
+         * `SIMD::oneToMany()` which runs on the structure of arrays copy
+         * of the particles, `Space::mirror`, using AVX-512, AVX2, or scalar
+         * code depending on the CPU. The pair potential must be supported
+         * by `setKernel()` and the geometry must use orthorhombic minimum
+         * image (cuboid, slit, cylinder, sphere). Energies agree with
+         * `Nonbonded` to within a relative `SIMD::tolerance`.
+         */
+        template<typename Tspace, typename Tpairpot>
+            class NonbondedVectorized : public Nonbonded<Tspace,Tpairpot> {
+                private:
+                    typedef Nonbonded<Tspace,Tpairpot> base;
+                    typedef typename Tspace::Tgroup Tgroup;
+                    typedef typename Tspace::Tparticle Tparticle;
+                    SIMD::PairKernel kernel;
+                    SIMD::Arrays arrays;
+
+                    int offset(const Tgroup &g) const {
+                        return g.begin() - base::spc.p.begin();
+                    } //!< Index of first particle in group
+
+                    double i2range(int i, int first, int last) const {
+                        auto &m = base::spc.mirror;
+                        return SIMD::oneToMany(kernel, m.x[i], m.y[i], m.z[i], m.charge[i], m.id[i], arrays, first, last);
+                    } //!< Energy of particle `i` with particles [first:last[
+
+                    double i2all(const Tparticle &a) override {
+                        auto &spc = base::spc;
+                        auto it = spc.findGroupContaining(a);
+                        if (it==spc.groups.end())
+                            return base::i2all(a);
+                        double u=0;
+                        int i = &a - &spc.p.front();
+                        for (auto &g : spc.groups)
+                            if (&g!=&(*it))
+                                if (not base::cut(g, *it))
+                                    u += i2range(i, offset(g), offset(g)+g.size());
+                        if (not molecules<typename Tspace::Tpvec>.at(it->id).exclusions.empty())
+                            return u + base::i2group(*it, i-offset(*it));
+                        return u + i2range(i, offset(*it), i) + i2range(i, i+1, offset(*it)+it->size());
+                    }
+
+                    double g_internal(const Tgroup &g, const std::vector<int> &index=std::vector<int>()) override {
+                        auto &traits = molecules<typename Tspace::Tpvec>.at(g.id);
+                        if (not index.empty() or traits.rigid or not traits.exclusions.empty())
+                            return base::g_internal(g, index);
+                        double u=0;
+                        int last = offset(g) + g.size();
+                        for (int i=offset(g); i<last; i++)
+                            u += i2range(i, i+1, last);
+                        return u;
+                    }
+
+                    double g2g(const Tgroup &g1, const Tgroup &g2, const std::vector<int> &index=std::vector<int>(),
+                            const std::vector<int> &jndex=std::vector<int>()) override {
+                        if (not jndex.empty())
+                            return base::g2g(g1, g2, index, jndex);
+                        double u=0;
+                        if (not base::cut(g1,g2)) {
+                            int first = offset(g2), last = first + g2.size();
+                            if (index.empty())
+                                for (int i=offset(g1); i<offset(g1)+int(g1.size()); i++)
+                                    u += i2range(i, first, last);
+                            else
+                                for (int i : index)
+                                    u += i2range(offset(g1)+i, first, last);
+                        }
+                        return u;
+                    }
+
+                    void to_json(json &j) const override {
+                        base::to_json(j);
+                        j["simd"] = SIMD::to_string( SIMD::instructionSet() );
+                    }
+
+                public:
+                    NonbondedVectorized(const json &j, Tspace &spc) : base(j,spc) {
+                        typedef Geometry::Chameleon G;
+                        if (spc.geo.type!=G::CUBOID && spc.geo.type!=G::SLIT
+                                && spc.geo.type!=G::CYLINDER && spc.geo.type!=G::SPHERE)
+                            throw std::runtime_error("simd requires a cuboid, slit, cylinder or sphere geometry");
+                        setKernel(kernel, base::pairpot);
+                        spc.mirror.enable(spc.p);
+                    }
+
+                    double energy(Change &change) override {
+                        auto &spc = base::spc;
+                        auto &m = spc.mirror; // kept up to date by `Space::update()`, `sync()`, `undo()` and `scaleVolume()`
+                        arrays = {m.x.data(), m.y.data(), m.z.data(), m.charge.data(), m.id.data()};
+                        auto &L = spc.geo.getBoundaryLength();
+                        kernel.setBox(L.x(), L.y(), L.z());
+                        return base::energy(change);
+                    }
+
+                    double delta(Change &change, Energybase *basePtr) override {
+                        return Energybase::delta(change, basePtr); // vectorized kernels are faster than fused scalar loops
+                    }
+            }; //!< Nonbonded using vectorized pair kernels
 
         /**
          * `udelta` is the total change of updating the energy function. If
@@ -1295,6 +2997,7 @@ namespace Faunus {
                     Penalty(const json &j, Tspace &spc) : spc(spc) {
                         using namespace ReactionCoordinate;
                         name = "penalty";
+                        undoable = false; // histogram is updated via `sync()`
                         overwrite_penalty = j.value("overwrite", true);
                         f0 = j.at("f0").get<double>();
                         scale = j.at("scale").get<double>();
@@ -1617,6 +3320,8 @@ namespace Faunus {
                 public:
                     SASAEnergy(const json &j, Tspace &spc) : spc(spc) {
                         name = "sasa";
+                        concurrent = false; // thread safety of PowerSasa is unknown
+                        undoable = false;
                         cite = "doi:10.1002/jcc.21844";
                         probe = j.value("radius", 1.4) * 1.0_angstrom;
                         conc = j.at("molarity").get<double>() * 1.0_molar;
@@ -1663,6 +3368,22 @@ namespace Faunus {
             class Hamiltonian : public Energybase, public BasePointerVector<Energybase> {
                 protected:
                     double maxenergy=pc::infty; //!< Maximum allowed energy change
+                    bool fused=false; //!< Evaluate trial energy changes in a single pass (see `delta()`)
+                    bool earlyreject=false; //!< Stop `delta()` once rejection is certain and evaluate cheap terms first
+                    double concurrent_mintime=-1; //!< Min. average time (microseconds) of concurrently evaluated terms; negative disables
+                    unsigned long deltacnt=0; //!< Number of `delta()` calls
+                    std::vector<size_t> order; //!< Evaluation order of terms in `delta()`
+                    size_t nonnegativefrom=0; //!< Terms in `order` from this position and on have non-negative energy changes
+
+                    void sortByCost() {
+                        order.resize(this->vec.size());
+                        std::iota(order.begin(), order.end(), 0);
+                        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+                                return this->vec[a]->timer.mean() < this->vec[b]->timer.mean(); });
+                        nonnegativefrom = order.size();
+                        while (nonnegativefrom>0 and this->vec[order[nonnegativefrom-1]]->nonnegative)
+                            nonnegativefrom--;
+                    } //!< Order terms by average evaluation time, cheapest first
                     typedef typename Tspace::Tparticle Tparticle;
                     void to_json(json &j) const override {
                         for (auto i : this->vec)
@@ -1670,12 +3391,33 @@ namespace Faunus {
                     }
 
                     void addEwald(const json &j, Tspace &spc) {
-                        if (j.count("coulomb")==1)
-                            if (j["coulomb"].count("type")==1)
-                                if (j["coulomb"].at("type")=="ewald")
-                                    push_back<Energy::Ewald<Tspace>>(j["coulomb"], spc);
+                        if (j.count("coulomb")==1 and j["coulomb"].count("type")==1) {
+                            if (j["coulomb"].at("type")=="ewald")
+                                push_back<Energy::Ewald<Tspace>>(j["coulomb"], spc);
+                            else if (j["coulomb"].at("type")=="spme")
+                                push_back<Energy::PME<Tspace>>(j["coulomb"], spc);
+                        }
                     } //!< Adds an instance of reciprocal space Ewald energies (if appropriate)
 
+                    template<class Tpairpot>
+                        void pushNonbonded(const json &j, Tspace &spc) {
+                            if (j.value("simd", false))
+                                push_back<Energy::NonbondedVectorized<Tspace,Tpairpot>>(j, spc);
+                            else
+                                push_back<Energy::Nonbonded<Tspace,Tpairpot>>(j, spc);
+                        } //!< Adds nonbonded energy using vectorized kernels if `simd` is true
+
+                    template<class Tpairpot>
+                        void pushCached(const json &j, Tspace &spc) {
+                            auto storage = j.value("cache", std::string("dense"));
+                            if (storage=="dense")
+                                push_back<Energy::NonbondedCached<Tspace,Tpairpot,EnergyMatrixDense>>(j, spc);
+                            else if (storage=="sparse")
+                                push_back<Energy::NonbondedCached<Tspace,Tpairpot,EnergyMatrixSparse>>(j, spc);
+                            else
+                                throw std::runtime_error("unknown energy matrix storage '" + storage + "'");
+                        } //!< Adds nonbonded energy w. cached group energies using `dense` or `sparse` storage
+
                 public:
                     Hamiltonian(Tspace &spc, const json &j) {
                         using namespace Potential;
@@ -1697,73 +3439,107 @@ namespace Faunus {
                             size_t oldsize = vec.size();
                             for (auto it=m.begin(); it!=m.end(); ++it) {
                                 try {
+                                    const json &val = autoEwald(it.value(), spc); // tuned Ewald parameters if requested
+
                                     if (it.key()=="nonbonded_coulomblj")
-                                        push_back<Energy::Nonbonded<Tspace,CoulombLJ>>(it.value(), spc);
+                                        pushNonbonded<CoulombLJ>(val, spc);
 
                                     if (it.key()=="nonbonded")
-                                        push_back<Energy::Nonbonded<Tspace,FunctorPotential<typename Tspace::Tparticle>>>(it.value(), spc);
+                                        push_back<Energy::Nonbonded<Tspace,FunctorPotential<typename Tspace::Tparticle>>>(val, spc);
+
+                                    if (it.key()=="nonbonded_celllist")
+                                        push_back<Energy::NonbondedNeighbors<Tspace,FunctorPotential<typename Tspace::Tparticle>>>(val, spc);
+
+                                    if (it.key()=="nonbonded_verlet")
+                                        push_back<Energy::NonbondedNeighbors<Tspace,FunctorPotential<typename Tspace::Tparticle>,
+                                            PolicyVerletList<Tspace>>>(val, spc);
 
                                     if (it.key()=="nonbonded_cached")
-                                        push_back<Energy::NonbondedCached<Tspace,FunctorPotential<typename Tspace::Tparticle>>>(it.value(), spc);
+                                        pushCached<FunctorPotential<typename Tspace::Tparticle>>(val, spc);
 
                                     if (it.key()=="nonbonded_coulombwca")
-                                        push_back<Energy::Nonbonded<Tspace,CoulombWCA>>(it.value(), spc);
+                                        pushNonbonded<CoulombWCA>(val, spc);
 
                                     if (it.key()=="nonbonded_coulombpolarwca")
-                                        push_back<Energy::Nonbonded<Tspace,CoulombPolarWCA>>(it.value(), spc);
+                                        push_back<Energy::Nonbonded<Tspace,CoulombPolarWCA>>(val, spc);
 
                                     if (it.key()=="nonbonded_pm" or it.key()=="nonbonded_coulombhs")
-                                        push_back<Energy::Nonbonded<Tspace,PrimitiveModel>>(it.value(), spc);
+                                        pushNonbonded<PrimitiveModel>(val, spc);
 
                                     if (it.key()=="nonbonded_pmwca")
-                                        push_back<Energy::Nonbonded<Tspace,PrimitiveModelWCA>>(it.value(), spc);
+                                        pushNonbonded<PrimitiveModelWCA>(val, spc);
 
                                     if (it.key()=="nonbonded_deserno")
-                                        push_back<Energy::NonbondedCached<Tspace,DesernoMembrane<typename Tspace::Tparticle>>>(it.value(), spc);
+                                        pushCached<DesernoMembrane<typename Tspace::Tparticle>>(val, spc);
+
+                                    if (it.key()=="nonbonded_deserno_verlet")
+                                        push_back<Energy::NonbondedNeighbors<Tspace,DesernoMembrane<typename Tspace::Tparticle>,
+                                            PolicyVerletList<Tspace>>>(val, spc);
 
                                     if (it.key()=="nonbonded_desernoAA")
-                                        push_back<Energy::NonbondedCached<Tspace,DesernoMembraneAA<typename Tspace::Tparticle>>>(it.value(), spc);
+                                        pushCached<DesernoMembraneAA<typename Tspace::Tparticle>>(val, spc);
 
                                     if (it.key()=="nonbonded_CookeRNA")
-                                        push_back<Energy::NonbondedCached<Tspace,CookeRNA<typename Tspace::Tparticle>>>(it.value(), spc);
+                                        pushCached<CookeRNA<typename Tspace::Tparticle>>(val, spc);
 
                                     if (it.key()=="bonded")
-                                        push_back<Energy::Bonded<Tspace>>(it.value(), spc);
+                                        push_back<Energy::Bonded<Tspace>>(val, spc);
 
                                     if (it.key()=="akesson")
-                                        push_back<Energy::ExternalAkesson<Tspace>>(it.value(), spc);
+                                        push_back<Energy::ExternalAkesson<Tspace>>(val, spc);
 
                                     if (it.key()=="confine")
-                                        push_back<Energy::Confine<Tspace>>(it.value(), spc);
+                                        push_back<Energy::Confine<Tspace>>(val, spc);
 
                                     if (it.key()=="constrain")
-                                        push_back<Energy::Constrain>(it.value(), spc);
+                                        push_back<Energy::Constrain>(val, spc);
 
                                     if (it.key()=="example2d")
-                                        push_back<Energy::Example2D>(it.value(), spc);
+                                        push_back<Energy::Example2D>(val, spc);
 
                                     if (it.key()=="isobaric")
-                                        push_back<Energy::Isobaric<Tspace>>(it.value(), spc);
+                                        push_back<Energy::Isobaric<Tspace>>(val, spc);
 
                                     if (it.key()=="penalty")
 #ifdef ENABLE_MPI
-                                        push_back<Energy::PenaltyMPI<Tspace>>(it.value(), spc);
+                                        push_back<Energy::PenaltyMPI<Tspace>>(val, spc);
 #else
-                                        push_back<Energy::Penalty<Tspace>>(it.value(), spc);
+                                        push_back<Energy::Penalty<Tspace>>(val, spc);
 #endif
 #ifdef ENABLE_POWERSASA
                                     if (it.key()=="sasa")
-                                        push_back<Energy::SASAEnergy<Tspace>>(it.value(), spc);
+                                        push_back<Energy::SASAEnergy<Tspace>>(val, spc);
 #endif
                                     // additional energies go here...
 
-                                    addEwald(it.value(), spc); // add reciprocal Ewald terms if appropriate
+                                    addEwald(val, spc); // add reciprocal Ewald terms if appropriate
 
                                     if (it.key()=="maxenergy") {
                                         maxenergy = it.value().get<double>();
                                         continue;
                                     }
 
+                                    if (it.key()=="fused") {
+                                        fused = it.value().get<bool>();
+                                        continue;
+                                    }
+
+                                    if (it.key()=="earlyreject") {
+                                        earlyreject = it.value().get<bool>();
+                                        continue;
+                                    }
+
+                                    if (it.key()=="singlestate")
+                                        continue; // handled by `MCSimulation`
+
+                                    if (it.key()=="concurrent") {
+                                        if (it.value().is_boolean())
+                                            concurrent_mintime = it.value().get<bool>() ? 0 : -1;
+                                        else
+                                            concurrent_mintime = it.value().value("mintime", 0.0);
+                                        continue;
+                                    }
+
                                     if (vec.size()==oldsize)
                                         throw std::runtime_error("unknown term");
 
@@ -1787,6 +3563,79 @@ namespace Faunus {
                         return du;
                     } //!< Energy due to changes
 
+                    double delta(Change &change, Energybase *basePtr) override {
+                        return delta(change, basePtr, pc::infty);
+                    } //!< Energy change relative to `other`, fused where supported by the terms
+
+                    /*
+                     * Energy change relative to `other`, evaluated term by term. Terms are fused
+                     * if enabled and, with early rejection, evaluated cheapest first and summed
+                     * only until the change exceeds `threshold`. The returned value is then a
+                     * partial sum which is sufficient to reject the move. Only terms whose energy
+                     * change cannot be negative (see `Energybase::nonnegative`) may be skipped
+                     * as others could bring the sum below `threshold`; an infinite partial sum
+                     * always stops the summation.
+                     */
+                    double delta(Change &change, Energybase *basePtr, double threshold) {
+                        auto other = dynamic_cast<decltype(this)>(basePtr);
+                        if (other==nullptr or other->size()!=size())
+                            throw std::runtime_error("hamiltonian mismatch");
+                        if (order.size()!=size() or (earlyreject and deltacnt % 1000 == 0))
+                            sortByCost(); // re-order terms periodically as timings accumulate
+                        deltacnt++;
+                        double du=0;
+                        for (size_t k=0; k<order.size(); k++) {
+                            size_t i = order[k];
+                            auto &term = this->vec[i];
+                            term->key = key;
+                            other->vec[i]->key = other->key;
+                            term->timer.start();
+                            if (fused)
+                                du += term->delta(change, other->vec[i].get());
+                            else
+                                du += term->Energybase::delta(change, other->vec[i].get());
+                            term->timer.stop();
+                            if (du>=maxenergy)
+                                break; // stop summing energies
+                            if (earlyreject and du>threshold and (std::isinf(du) or k+1>=nonnegativefrom))
+                                break; // move will be rejected as the remaining terms cannot lower `du`
+                        }
+                        return du;
+                    }
+
+                    /*
+                     * Sum of terms where `mask` equals `select`. Together with `concurrentMask()` this
+                     * splits the energy into a part that can run concurrently with the other state
+                     * and a part that must run serially.
+                     */
+                    double energy(Change &change, const std::vector<bool> &mask, bool select) {
+                        assert(mask.size()==size());
+                        double du=0;
+                        for (size_t i=0; i<size(); i++)
+                            if (mask[i]==select) {
+                                auto &term = this->vec[i];
+                                term->key=key;
+                                term->timer.start();
+                                du += term->energy(change);
+                                term->timer.stop();
+                                if (du>=maxenergy)
+                                    break; // stop summing energies
+                            }
+                        return du;
+                    }
+
+                    std::vector<bool> concurrentMask() const {
+                        std::vector<bool> mask(size(), false);
+                        if (concurrent_mintime>=0)
+                            for (size_t i=0; i<size(); i++)
+                                mask[i] = this->vec[i]->concurrent and this->vec[i]->timer.mean() >= concurrent_mintime;
+                        return mask;
+                    } //!< Terms that are safe and expensive enough to evaluate concurrently with the other state
+
+                    bool isConcurrent() const { return concurrent_mintime>=0; } //!< True if moves should evaluate states concurrently
+                    bool isFused() const { return fused; } //!< True if moves should use `delta()`
+                    bool isEarlyReject() const { return earlyreject; } //!< True if moves should use `delta()` w. rejection threshold
+
                     void init() override {
                         for (auto i : this->vec)
                             i->init();
@@ -1805,5 +3654,68 @@ namespace Faunus {
 
             }; //!< Aggregates and sum energy terms
 
+#ifdef DOCTEST_LIBRARY_INCLUDED
+        TEST_CASE("[Faunus] Hamiltonian - early rejection")
+        {
+            typedef Space<Geometry::Chameleon, Particle<Charge>> Tspace;
+            typedef Nonbonded<Tspace, Potential::CoulombGalore> Tnonbonded;
+
+            SaltFixture<Tspace> salt( R"( {"type": "sphere", "radius": 10} )"_json );
+            salt.addSalt(50);
+            auto &slump = salt.slump;
+            auto &spc2 = salt.spc; // trial
+            Tspace spc1;           // old
+            Change all;
+            all.all = true;
+            spc1.sync(spc2, all);
+
+            // overlap (non-negative), two nonbonded terms (either sign), and overlap again
+            json j = R"({"energy": [{"earlyreject": true}]})"_json;
+            json nb = R"({"coulomb": {"type": "plain", "epsr": 80, "cutoff": 100}})"_json;
+            Hamiltonian<Tspace> pot1(spc1, j), pot2(spc2, j);
+            for (auto v : { std::make_pair(&pot1, &spc1), std::make_pair(&pot2, &spc2) }) {
+                v.first->push_back<Tnonbonded>(nb, *v.second);
+                v.first->push_back<Tnonbonded>(nb, *v.second);
+                v.first->push_back<ContainerOverlap<Tspace>>(*v.second);
+            }
+            pot1.key = Energybase::OLD;
+            pot2.key = Energybase::NEW;
+            CHECK( pot2.size()==4 );
+            CHECK( pot2.isEarlyReject() );
+
+            Change change;
+            change.groups.resize(1);
+            change.groups[0].index = 0;
+            change.groups[0].atoms = {0};
+            int overlaps=0, accepted=0, rejected=0;
+            for (int n=0; n<500; n++) {
+                int i = slump.range(0, int(spc2.p.size())-1);
+                change.groups[0].atoms[0] = i;
+                spc2.p[i].pos += (Point(slump(), slump(), slump()) - Point(0.5,0.5,0.5)) * 4;
+                spc2.update(change);
+                double threshold = (slump()-0.5) * 4; // negative thresholds mimic a bias
+                double du = pot2.delta(change, &pot1); // all terms
+                double partial = pot2.delta(change, &pot1, threshold);
+                CHECK( (partial>threshold) == (du>threshold) );
+                if (std::isinf(du)) {
+                    CHECK( std::isinf(partial) );
+                    overlaps++;
+                }
+                if (du>threshold) {
+                    rejected++;
+                    spc2.sync(spc1, change);
+                    pot2.sync(&pot1, change);
+                } else {
+                    accepted++;
+                    spc1.sync(spc2, change);
+                    pot1.sync(&pot2, change);
+                }
+            }
+            CHECK( overlaps>0 );
+            CHECK( accepted>0 );
+            CHECK( rejected>overlaps );
+        }
+#endif
+
     }//namespace
 }//namespace
@@ -130,6 +130,7 @@ namespace Faunus {
                 double getVolume(int dim=3) const override;
                 Point setVolume(double V, VolumeMethod method=ISOTROPIC) override;
                 Point getLength() const override; //!< Enscribed box
+                inline const Point& getBoundaryLength() const { return len; } //!< Side lengths used by `vdist()` (large if no PBC)
                 void randompos( Point &m, Random &rand ) const override;
                 bool collision(const Point &a) const override;
                 void from_json(const json &j);
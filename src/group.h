@@ -157,6 +157,7 @@ namespace Faunus {
             int confid=0;        //!< Conformation index / id
             Point cm={0,0,0};    //!< Mass center
             bool atomic=false;   //!< Is it an atomic group?
+            double radius=pc::infty; //!< Radius of sphere around `cm` enclosing all active particles (see `updateRadius()`)
 
             const auto& traits() const {
                 return molecules<Tpvec>.at(id);
@@ -189,6 +190,7 @@ namespace Faunus {
                     id = o.id;
                     atomic = o.atomic;
                     cm = o.cm;
+                    radius = o.radius;
                     confid = o.confid;
                 }
                 return *this;
@@ -236,6 +238,18 @@ namespace Faunus {
                 return ranges::view::transform(*this, [](auto &i) -> Point& {return i.pos;});
             } //!< Iterable range with positions
 
+            template<typename TdistanceFunc>
+                void updateRadius(const TdistanceFunc &vdist) {
+                    if (atomic)
+                        radius = pc::infty;
+                    else {
+                        double r2=0;
+                        for (auto &i : *this)
+                            r2 = std::max(r2, vdist(i.pos, cm).squaredNorm());
+                        radius = std::sqrt(r2);
+                    }
+                } //!< Update bounding radius from active particles; atomic groups are unbounded (Order N complexity).
+
             // warning! this should be tested -- do not use yet.
             template<typename TdistanceFunc>
                 void unwrap(const TdistanceFunc &vdist) {
@@ -332,6 +346,17 @@ namespace Faunus {
         CHECK( p[1].pos.y() == doctest::Approx(10) );
         CHECK( p[1].pos.z() == doctest::Approx(12) );
 
+        // bounding radius
+        CHECK( g.radius == pc::infty ); // unknown until updated
+        auto vdist = [](const Point &a, const Point &b) -> Point { return a-b; };
+        g.cm = p[1].pos;
+        g.updateRadius(vdist);
+        CHECK( g.radius == doctest::Approx( std::max( (p[0].pos-g.cm).norm(), (p[2].pos-g.cm).norm() ) ) );
+        g.atomic = true;
+        g.updateRadius(vdist);
+        CHECK( g.radius == pc::infty );
+        g.atomic = false;
+
         SUBCASE("operator[]") {
             CHECK( p.begin() == g.begin() );
             CHECK( p.end() == g.end() );
@@ -360,12 +385,14 @@ namespace Faunus {
         g2.id=100;
         g2.atomic=true;
         g2.cm={1,0,0};
+        g2.radius=2;
         g2.confid=20;
         g1=g2;
 
         CHECK(g1.id==100);
         CHECK(g1.atomic==true);
         CHECK(g1.cm.x()==1);
+        CHECK(g1.radius==2);
         CHECK(g1.confid==20);
 
         CHECK( *g1.begin()==-1);
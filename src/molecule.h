@@ -144,6 +144,78 @@ namespace Faunus {
         CHECK( p[0].charge == 0.5 );
     }
 #endif
+
+    /**
+     * @brief Atom pairs within a molecule for which non-bonded interactions are excluded
+     *
+     * The list is built from bonds with `exclude=true` and all pairs of atoms
+     * in such a bond are excluded. If `keepelectrostatics=true` the
+     * electrostatic part of the pair potential is kept. Atom indices are
+     * relative to the first atom in the molecule and the excluded partners
+     * of each atom are kept in a sorted list.
+     */
+    class ExclusionList {
+        public:
+            enum Type {NONE=0, KEEPELECTROSTATICS, ALL};
+        private:
+            typedef std::pair<int,Type> Tpartner;
+            std::vector<std::vector<Tpartner>> partners; // sorted excluded partners for each atom
+
+            void insert(int i, int j, Type type) {
+                if ((int)partners.size()<=i)
+                    partners.resize(i+1);
+                auto &v = partners[i];
+                auto it = std::lower_bound(v.begin(), v.end(), j, [](const Tpartner &a, int j){ return a.first<j; });
+                if (it!=v.end() && it->first==j)
+                    it->second = std::min(it->second, type); // keep electrostatics if any bond asks for it
+                else
+                    v.insert(it, {j,type});
+            }
+
+        public:
+            void add(int i, int j, Type type) {
+                if (i!=j && type!=NONE) {
+                    insert(i, j, type);
+                    insert(j, i, type);
+                }
+            } //!< Exclude pair of atoms
+
+            void add(const Potential::BondData &bond) {
+                if (bond.exclude)
+                    for (size_t k=0; k<bond.index.size(); k++)
+                        for (size_t l=k+1; l<bond.index.size(); l++)
+                            add(bond.index[k], bond.index[l], bond.keepelectrostatics ? KEEPELECTROSTATICS : ALL);
+            } //!< Exclude all atom pairs in bond if `exclude=true`
+
+            Type operator()(int i, int j) const {
+                if (i<(int)partners.size()) {
+                    auto &v = partners[i];
+                    auto it = std::lower_bound(v.begin(), v.end(), j, [](const Tpartner &a, int j){ return a.first<j; });
+                    if (it!=v.end() && it->first==j)
+                        return it->second;
+                }
+                return NONE;
+            } //!< Exclusion type of atom pair
+
+            bool empty() const { return partners.empty(); } //!< True if no exclusions
+    };
+#ifdef DOCTEST_LIBRARY_INCLUDED
+    TEST_CASE("[Faunus] ExclusionList") {
+        ExclusionList ex;
+        CHECK( ex.empty() );
+        CHECK( ex(0,1)==ExclusionList::NONE );
+        ex.add(3, 1, ExclusionList::ALL);
+        ex.add(1, 2, ExclusionList::KEEPELECTROSTATICS);
+        CHECK( not ex.empty() );
+        CHECK( ex(1,3)==ExclusionList::ALL );
+        CHECK( ex(3,1)==ExclusionList::ALL );
+        CHECK( ex(2,1)==ExclusionList::KEEPELECTROSTATICS );
+        CHECK( ex(2,3)==ExclusionList::NONE );
+        CHECK( ex(10,3)==ExclusionList::NONE );
+        ex.add(1, 3, ExclusionList::KEEPELECTROSTATICS);
+        CHECK( ex(3,1)==ExclusionList::KEEPELECTROSTATICS );
+    }
+#endif
  
     /**
      * @brief General properties for molecules
@@ -176,6 +248,7 @@ namespace Faunus {
                 Point insoffset = {0,0,0}; //!< Insertion offset
 
                 std::vector<std::shared_ptr<Potential::BondData>> bonds;
+                ExclusionList exclusions;  //!< Excluded non-bonded atom pairs (from `bonds`)
                 std::vector<int> atoms;    //!< Sequence of atoms in molecule (atom id's)
                 WeightedDistribution<Tpvec> conformations;//!< Conformations of molecule
 
@@ -391,6 +464,10 @@ namespace Faunus {
                         for (int i : bond->index)
                             if (i>=a.atoms.size() || i<0)
                                 throw std::runtime_error("bonded atom index " + std::to_string(i) + " out of range");
+
+                    a.exclusions = ExclusionList();
+                    for (auto &bond : a.bonds)
+                        a.exclusions.add(*bond);
                     // at this stage all given keys should have been accessed. If any are
                     // left, an exception will be thrown.
                     if (not val.empty())
@@ -4,7 +4,7 @@
 namespace Faunus {
     namespace Move {
 
-        Random Movebase::slump; // static instance of Random (shared for all moves)
+        thread_local Random Movebase::slump; // static instance of Random (shared for all moves in a thread)
 
         void Movebase::from_json(const json &j) {
             auto it = j.find("repeat");
@@ -58,6 +58,12 @@ namespace Faunus {
             timer.stop();
         }
 
+        void Movebase::discard(Change &c) {
+            cnt--;
+            if (not c.empty())
+                timer.stop();
+        }
+
         double Movebase::bias(Change&, double, double) {
             return 0; // du
         }
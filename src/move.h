@@ -10,6 +10,25 @@
 namespace Faunus {
     namespace Move {
 
+        inline double energyChange(double uold, double unew, double du) {
+            // if any energy returns NaN (from i.e. division by zero), the
+            // configuration will always be rejected, or if moving from NaN
+            // to a finite energy, always accepted.
+
+            if (std::isnan(uold) and not std::isnan(unew))
+                return -pc::infty; // accept
+            else if (std::isnan(unew))
+                return pc::infty; // reject
+
+            // if the difference in energy is NaN (from i.e. infinity minus infinity), the
+            // configuration will always be accepted. This should be
+            // noted during equilibration.
+
+            else if (std::isnan(du))
+                return 0; // accept
+            return du;
+        } //!< Energy change used for acceptance, handling NaN and infinite energies
+
         class Movebase {
             private:
                 virtual void _move(Change&)=0; //!< Perform move and modify change object
@@ -24,16 +43,23 @@ namespace Faunus {
                 unsigned long accepted=0;
                 unsigned long rejected=0;
             public:
-                static Random slump;   //!< Shared for all moves
+                static thread_local Random slump; //!< Shared for all moves (one per thread, see `MCSimulation::moveSpeculative()`)
                 std::string name;      //!< Name of move
                 std::string cite;      //!< Reference
                 int repeat=1;          //!< How many times the move should be repeated per sweep
+                bool energybias=false; //!< True if `bias()` depends on the energies (disables early rejection)
+                bool undoable=false;   //!< True if `Space::backup()` is called before modifications (required for single-state simulations)
+                bool sampled=false;    //!< True if the move applies the Metropolis criterion to its own trials; the change is then always accepted
+                double dusampled=0;    //!< Energy change of the trials accepted by a `sampled` move
 
                 void from_json(const json &j);
                 void to_json(json &j) const; //!< JSON report w. statistics, output etc.
                 void move(Change &change); //!< Perform move and modify given change object
                 void accept(Change &c);
                 void reject(Change &c);
+                void discard(Change &c); //!< Call instead of `accept()` or `reject()` if the trial is thrown away
+                unsigned long trials() const { return cnt; } //!< Number of trial moves
+                unsigned long acceptedTrials() const { return accepted; } //!< Number of accepted trial moves
                 virtual double bias(Change&, double uold, double unew); //!< adds extra energy change not captured by the Hamiltonian
                 inline virtual ~Movebase() {};
         };
@@ -140,7 +166,7 @@ namespace Faunus {
          */
         template<typename Tspace>
             class AtomicTranslateRotate : public Movebase {
-                private:
+                protected:
                     typedef typename Tspace::Tpvec Tpvec;
                     typedef typename Tspace::Tparticle Tparticle;
                     Tspace& spc; // Space to operate on
@@ -164,7 +190,7 @@ namespace Faunus {
                     void _from_json(const json &j) override {
                         assert(!molecules<Tpvec>.empty());
                         try {
-                            assertKeys(j, {"molecule", "dir", "repeat"});
+                            assertKeys(j, {"molecule", "dir", "repeat", "parallel"});
                             molname = j.at("molecule");
                             auto it = findName(molecules<Tpvec>, molname);
                             if (it == molecules<Tpvec>.end())
@@ -205,6 +231,10 @@ namespace Faunus {
                             double dp = atoms.at(p->id).dp;
                             double dprot = atoms.at(p->id).dprot;
                             auto& g = spc.groups[cdata.index];
+                            if (g.atomic)
+                                spc.backup(cdata.index, cdata.atoms[0]);
+                            else
+                                spc.backup(cdata.index); // mass center recalculation may touch all atoms
 
                             if (dp>0) { // translate
                                 Point oldpos = p->pos;
@@ -247,11 +277,257 @@ namespace Faunus {
                     AtomicTranslateRotate(Tspace &spc) : spc(spc) {
                         name = "transrot";
                         repeat = -1; // meaning repeat N times
+                        undoable = true;
                         cdata.atoms.resize(1);
                         cdata.internal=true;
                     }
             };
 
+        /**
+         * @brief Parallel sweep of atomic translations and rotations using domain decomposition
+         *
+         * Each sweep attempts to move all active atoms of an atomic molecule once. The box is divided
+         * into a randomly shifted cell list with cells no smaller than the largest interaction range of
+         * the energy terms (see `Energybase::interactionRange()`) and with an even number of cells in
+         * each direction. The cells are visited in eight phases of a 2x2x2 checkerboard where
+         * cells of the same colour are never adjacent and can be swept in parallel on the thread pool.
+         * Atoms are confined to their cell during a sweep so that atoms moved in different cells never
+         * interact, and each trial is accepted or rejected using the particle energies with the 26+1
+         * surrounding cells (see `Energybase::particleEnergy()`). The accepted displacements are
+         * merged into a single `Change` object which is always accepted (see `Movebase::sampled`).
+         *
+         * Random numbers are drawn from a stream for each cell and sweep so that the outcome is
+         * independent of the number of threads.
+         */
+        template<typename Tspace>
+            class ParallelAtomicTranslateRotate : public AtomicTranslateRotate<Tspace> {
+                private:
+                    typedef AtomicTranslateRotate<Tspace> base;
+                    typedef typename Tspace::Tpvec Tpvec;
+                    using base::spc;
+                    using base::slump;
+
+                    struct CellResult {
+                        std::vector<int> accepted; //!< Index of accepted particles
+                        std::vector<double> sqd;   //!< Squared displacement of each trial (zero if rejected)
+                        double du=0;               //!< Energy change of accepted trials
+                    }; //!< Outcome of trials in a single cell
+
+                    Energy::Hamiltonian<Tspace> &pot;
+                    CellList<Eigen::Vector3i> cells;
+                    std::vector<std::vector<int>> colors; // cell index of each of the eight colours
+                    std::vector<CellResult> results;      // one for each cell
+                    std::vector<int> owner;               // group index of movable particles; -1 if not moved
+                    Point shift={0,0,0};                  // offset of the cell grid
+                    double range=0;                       // max. interaction range of all energy terms
+                    unsigned int seed=0;                  // base seed of the current sweep
+                    unsigned long atomtrials=0, atomaccepted=0;
+
+                    void _to_json(json &j) const override {
+                        base::_to_json(j);
+                        j["parallel"] = true;
+                        j["cells"] = { cells.KLM[0]+1, cells.KLM[1]+1, cells.KLM[2]+1 };
+                        if (atomtrials>0)
+                            j["atomic acceptance"] = double(atomaccepted) / atomtrials;
+                        _roundjson(j,3);
+                    }
+
+                    void _from_json(const json &j) override {
+                        base::_from_json(j);
+                        if (not molecules<Tpvec>.at(base::molid).atomic)
+                            throw std::runtime_error("parallel sweeps require an atomic molecule");
+                        if (not molecules<Tpvec>.at(base::molid).exclusions.empty())
+                            throw std::runtime_error("parallel sweeps do not support exclusions");
+                        range = 0;
+                        for (auto &term : pot.vec) {
+                            double r = term->interactionRange();
+                            if (r<0)
+                                throw std::runtime_error("energy term '" + term->name + "' does not support parallel sweeps");
+                            if (not std::isfinite(r))
+                                throw std::runtime_error("energy term '" + term->name + "' has no finite cutoff");
+                            range = std::max(range, r);
+                        }
+                        if (j.count("repeat")==0)
+                            Movebase::repeat = 1; // one sweep moves all atoms
+                    } //!< Configure via json object and check that all energy terms are short ranged
+
+                    double energy(int i, const std::vector<int> &neighbors) {
+                        double u=0;
+                        for (auto &term : pot.vec)
+                            u += term->particleEnergy(i, neighbors);
+                        return u;
+                    } //!< Energy of particle `i` with `neighbors` summed over all energy terms
+
+                    void resize() {
+                        Point box = spc.geo.getLength();
+                        Eigen::Vector3i n = (box/range).array().floor().template cast<int>();
+                        for (int d=0; d<3; d++)
+                            n[d] -= n[d] % 2; // even number of cells for the checkerboard
+                        if (n.minCoeff()<4)
+                            throw std::runtime_error(base::name + ": box too small for parallel sweeps");
+                        if (cells.size()==n.prod() and (cells.cellSize().cwiseProduct(n.template cast<double>())-box).norm()<1e-9)
+                            return;
+                        cells.resize(box, n);
+                        colors.assign(8, {});
+                        Eigen::Vector3i c;
+                        for (c[0]=0; c[0]<n[0]; c[0]++)
+                            for (c[1]=0; c[1]<n[1]; c[1]++)
+                                for (c[2]=0; c[2]<n[2]; c[2]++)
+                                    colors[ (c[0]%2) + 2*(c[1]%2) + 4*(c[2]%2) ].push_back( cells.c2i(c) );
+                        results.resize( cells.size() );
+                    } //!< Set up cells and colours if the box has changed
+
+                    void sweep(int c) {
+                        static thread_local std::vector<int> order, neighbors;
+                        auto &r = results[c];
+                        r.accepted.clear();
+                        r.sqd.clear();
+                        r.du = 0;
+
+                        order.clear();
+                        for (int i : cells[c])
+                            if (owner[i]>=0)
+                                order.push_back(i);
+                        if (order.empty())
+                            return;
+                        std::seed_seq seq {seed, unsigned(c)};
+                        slump.engine.seed(seq);
+                        std::shuffle(order.begin(), order.end(), slump.engine);
+                        neighbors.clear();
+                        cells.forEachNeighbor(c, [&](int j){ neighbors.push_back(j); });
+
+                        for (int i : order) {
+                            auto &p = spc.p[i];
+                            double dp = atoms.at(p.id).dp;
+                            double dprot = atoms.at(p.id).dprot;
+                            double uold = energy(i, neighbors);
+                            auto old = p;
+                            if (dp>0) { // translate
+                                p.pos += ranunit(slump, base::dir) * dp * slump();
+                                spc.geo.boundary(p.pos);
+                            }
+                            if (dprot>0) { // rotate
+                                Point u = ranunit(slump);
+                                double angle = dprot * (slump()-0.5);
+                                Eigen::Quaterniond Q( Eigen::AngleAxisd(angle, u) );
+                                p.rotate(Q, Q.toRotationMatrix());
+                            }
+                            double random = slump();
+                            if (cells.p2i( p.pos - shift ) == c) { // atoms must stay in the cell
+                                double unew = energy(i, neighbors);
+                                double du = energyChange(uold, unew, unew - uold);
+                                if (du<0 or random <= std::exp(-du)) {
+                                    r.accepted.push_back(i);
+                                    r.sqd.push_back( spc.geo.sqdist(old.pos, p.pos) );
+                                    r.du += du;
+                                    continue;
+                                }
+                            }
+                            p = old; // reject
+                            r.sqd.push_back(0);
+                        }
+                    } //!< Attempt to move all movable atoms in cell `c` (thread safe for non-adjacent cells)
+
+                    void _move(Change &change) override {
+                        resize();
+                        Movebase::dusampled = 0;
+
+                        for (int d=0; d<3; d++)
+                            shift[d] = slump() * cells.cellSize()[d];
+                        std::vector<int> phases = {0,1,2,3,4,5,6,7};
+                        std::shuffle(phases.begin(), phases.end(), slump.engine);
+                        seed = slump.engine();
+
+                        owner.assign( spc.p.size(), -1 );
+                        cells.clear();
+                        for (auto &g : spc.groups) {
+                            int offset = g.begin() - spc.p.begin();
+                            for (int i=offset; i<offset+int(g.size()); i++)
+                                cells.insert(i, cells.p2i( spc.p[i].pos - shift ));
+                        }
+                        for (auto &g : spc.findMolecules(base::molid)) {
+                            int gindex = &g - &spc.groups.front();
+                            spc.backup(gindex); // before concurrent modification
+                            for (auto it=g.begin(); it!=g.end(); ++it)
+                                owner[ it - spc.p.begin() ] = gindex;
+                        }
+
+                        auto engine = slump.engine; // cells re-seed the (thread local) generator
+                        for (int k : phases) {
+                            auto &v = colors[k];
+                            threadPool().sum(v.size(), [&](size_t n){ sweep(v[n]); return 0.0; });
+                        }
+                        slump.engine = engine;
+
+                        std::vector<int> accepted;
+                        for (auto &r : results) {
+                            accepted.insert(accepted.end(), r.accepted.begin(), r.accepted.end());
+                            for (double x : r.sqd)
+                                base::msqd += x;
+                            atomtrials += r.sqd.size();
+                            Movebase::dusampled += r.du;
+                        }
+                        atomaccepted += accepted.size();
+                        std::sort(accepted.begin(), accepted.end());
+
+                        for (int i : accepted) { // merge into change object; one entry per group
+                            int gindex = owner[i];
+                            if (change.groups.empty() or change.groups.back().index!=gindex) {
+                                Change::data d;
+                                d.index = gindex;
+                                d.internal = true;
+                                change.groups.push_back(d);
+                            }
+                            change.groups.back().atoms.push_back( i - (spc.groups[gindex].begin() - spc.p.begin()) );
+                        }
+                    }
+
+                    void _accept(Change&) override {}
+                    void _reject(Change&) override {}
+
+                public:
+                    ParallelAtomicTranslateRotate(Tspace &spc, Energy::Hamiltonian<Tspace> &pot) : base(spc), pot(pot) {
+                        Movebase::sampled = true;
+                    }
+            };
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+        TEST_CASE("[Faunus] ParallelAtomicTranslateRotate")
+        {
+            typedef Space<Geometry::Chameleon, Particle<Charge>> Tspace;
+
+            SaltFixture<Tspace> salt( R"( {"type": "cuboid", "length": 30} )"_json ); // 6x6x6 cells
+            salt.addSalt(200);
+            auto &spc = salt.spc;
+
+            json in = R"({"molecule": "salt"})"_json;
+            json nb = R"({"type": "plain", "epsr": 80, "cutoff": 5})"_json;
+            json none = R"({"energy": []})"_json;
+            Energy::Hamiltonian<Tspace> pot(spc, none);
+            pot.push_back<Energy::Nonbonded<Tspace, Potential::CoulombGalore>>(nb, spc);
+
+            ParallelAtomicTranslateRotate<Tspace> mv(spc, pot);
+            mv.from_json(in);
+
+            Change all;
+            all.all = true;
+            for (int n=0; n<3; n++) {
+                double before = pot.energy(all);
+                Change change;
+                mv.move(change);
+                CHECK( not change.empty() );
+                CHECK( pot.energy(all) == doctest::Approx(before + mv.dusampled) );
+            }
+
+            // pair potentials that are not thread safe are rejected
+            json custom = R"({"function": "q1*q2/r", "cutoff": 5})"_json;
+            Energy::Hamiltonian<Tspace> pot2(spc, none);
+            pot2.push_back<Energy::Nonbonded<Tspace, Potential::CustomPairPotential>>(custom, spc);
+            ParallelAtomicTranslateRotate<Tspace> mv2(spc, pot2);
+            CHECK_THROWS( mv2.from_json(in) );
+        }
+#endif
+
         /**
          * @brief Translate and rotate a molecular group
          */
@@ -310,6 +586,7 @@ namespace Faunus {
                             auto it = slump.sample( mollist.begin(), mollist.end() );
                             if (not it->empty()) {
                                 assert(it->id==molid);
+                                spc.backup( Faunus::distance(spc.groups.begin(), it) );
 
                                 if (dptrans>0) { // translate
                                     Point oldcm = it->cm;
@@ -346,6 +623,7 @@ namespace Faunus {
                     TranslateRotate(Tspace &spc) : spc(spc) {
                         name = "moltransrot";
                         repeat = -1; // meaning repeat N times
+                        undoable = true;
                     }
             };
 
@@ -535,6 +813,9 @@ namespace Faunus {
                     }
 
                     void _move(Change &change) override {
+                        undoable = spc.scaleVolumeTriggers.empty(); // triggers may have been added after construction
+                        if (not undoable and spc.undolog.enabled)
+                            throw std::runtime_error("volume: volume scaling triggers cannot be undone; use two states");
                         if (dV>0) {
                             change.dV=true;
                             change.all=true;
@@ -543,6 +824,7 @@ namespace Faunus {
                                 Vold = std::pow(Vold,1.0/3.0); // volume is constant
                             Vnew = std::exp(std::log(Vold) + (slump()-0.5) * dV);
                             deltaV = Vnew-Vold;
+                            spc.backupAll();
                             spc.scaleVolume(Vnew, method->second);
                         } else deltaV=0;
                     }
@@ -560,6 +842,7 @@ namespace Faunus {
                     VolumeMove(Tspace &spc) : spc(spc) {
                         name = "volume";
                         repeat = 1;
+                        undoable = spc.scaleVolumeTriggers.empty(); // triggers may modify data outside space; re-checked in `_move()`
                     }
             }; // end of VolumeMove
 
@@ -598,6 +881,7 @@ namespace Faunus {
 
                     void _move(Change &change) override {
                         if (dq>0) {
+                            spc.backup(cdata.index, cdata.atoms[0]);
                             auto &p = spc.p[atomIndex]; // refence to particle
                             double qold = p.charge;
                             p.charge +=  dq * (slump()-0.5);
@@ -613,6 +897,7 @@ namespace Faunus {
                     ChargeMove(Tspace &spc) : spc(spc) {
                         name = "charge";
                         repeat = 1;
+                        undoable = true;
                         cdata.internal=true; // the group is internally changed
                         cdata.atoms.resize(1); // we change exactly one atom
                     }
@@ -741,6 +1026,7 @@ namespace Faunus {
                                 p.pos = ait->pos;
                                 *ait = p;
                                 assert(ait->id == m2.begin()->first);
+                                spc.reindexParticle( Faunus::distance(spc.p.begin(), ait) ); // invalidates `ait`
                             }
 
                             change.dN=true; // Attempting to change the number of atoms / molecules
@@ -762,10 +1048,14 @@ namespace Faunus {
                                         if ( Faunus::distance( ait, nait) > 1 ) {
                                             std::iter_swap(ait, nait);
                                             std::iter_swap(othergit->end()-dist-N, othergit->end() - (1+N) );
+                                            spc.reindexParticle( Faunus::distance(spc.p.begin(), ait) ); // atom types were swapped
+                                            otherspc->reindexParticle( Faunus::distance(otherspc->p.begin(), othergit->end()-dist-N) );
+                                            otherspc->reindexParticle( Faunus::distance(otherspc->p.begin(), othergit->end()-(1+N)) );
                                         }
                                         d.atoms.push_back ( Faunus::distance(git->begin(), nait) );
                                         git->deactivate( nait, git->end());
                                     }
+                                    spc.reindex(d);
                                     std::sort( d.atoms.begin(), d.atoms.end() );
                                     change.groups.push_back( d ); // add to list of moved groups
                                 } else {
@@ -780,6 +1070,7 @@ namespace Faunus {
                                         for (int i=0; i<git->capacity(); i++)
                                             d.atoms.push_back(i);
                                         change.groups.push_back( d ); // add to list of moved groups
+                                        spc.reindex(d.index); // invalidates `git`
                                     }
                                 }
                             }
@@ -799,6 +1090,7 @@ namespace Faunus {
                                         spc.geo.getBoundaryFunc()(ait->pos);
                                         d.atoms.push_back( Faunus::distance(git->begin(), ait) );  // Index of particle rel. to group
                                     }
+                                    spc.reindex(d);
                                     std::sort( d.atoms.begin(), d.atoms.end());
                                     change.groups.push_back( d ); // Add to list of moved groups
                                 } else {
@@ -821,6 +1113,7 @@ namespace Faunus {
                                             d.atoms.push_back(i);
                                         change.groups.push_back( d ); // Add to list of moved groups
                                         assert( spc.geo.sqdist( git->cm, Geometry::massCenter(git->begin(),git->end(),spc.geo.getBoundaryFunc(), -git->cm ) ) < 1e-9 );
+                                        spc.reindex(d.index); // invalidates `git`
                                     }
 
                                 }
@@ -1213,6 +1506,7 @@ start:
                                         i2+=offset;
 
                                         if (not index.empty()) {
+                                            spc.backup( Faunus::distance(spc.groups.begin(), g) );
                                             Point oldcm = g->cm;
                                             Point shift = spc.p[i1].pos; // center around this point to disable PBC
                                             g->translate(-shift, spc.geo.getBoundaryFunc());
@@ -1267,6 +1561,7 @@ start:
                     Pivot(Tspace &spc) : spc(spc) {
                         name = "pivot";
                         repeat = -1; // --> repeat=N
+                        undoable = true;
                     }
             }; //!< Pivot move around random harmonic bond axis
 
@@ -1397,6 +1692,7 @@ start:
                 public:
                     ParallelTempering(Tspace &spc, MPI::MPIController &mpi ) : spc(spc), mpi(mpi) {
                         name="temper";
+                        energybias=true; // bias exchanges the energy change with partner
                         partner=-1;
                         pt.recvExtra.resize(1);
                         pt.sendExtra.resize(1);
@@ -1422,7 +1718,7 @@ start:
                     inline Propagator() {}
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
-                    inline Propagator(const json &j, Tspace &spc, MPI::MPIController &mpi) {
+                    inline Propagator(const json &j, Tspace &spc, Energy::Hamiltonian<Tspace> &pot, MPI::MPIController &mpi) {
 #pragma GCC diagnostic pop
                         if (j.count("random")==1)
                             Movebase::slump = j["random"]; // slump is static --> shared for all moves
@@ -1433,6 +1729,8 @@ start:
                                 try {
                                     if (it.key()=="moltransrot") this->template push_back<Move::TranslateRotate<Tspace>>(spc);
                                     else if (it.key()=="conformationswap") this->template push_back<Move::ConformationSwap<Tspace>>(spc);
+                                    else if (it.key()=="transrot" and it.value().value("parallel", false))
+                                        this->template push_back<Move::ParallelAtomicTranslateRotate<Tspace>>(spc, pot);
                                     else if (it.key()=="transrot") this->template push_back<Move::AtomicTranslateRotate<Tspace>>(spc);
                                     else if (it.key()=="pivot") this->template push_back<Move::Pivot<Tspace>>(spc);
                                     else if (it.key()=="volume") this->template push_back<Move::VolumeMove<Tspace>>(spc);
@@ -1488,6 +1786,14 @@ start:
                     return ( Move::Movebase::slump() > std::exp(-du)) ? false : true;
                 } //!< Metropolis criterion (true=accept)
 
+                bool metropolis(double du, double random) const {
+                    if (std::isnan(du))
+                        throw std::runtime_error("Metropolis error: energy cannot be NaN");
+                    if (du<0)
+                        return true;
+                    return ( random > std::exp(-du)) ? false : true;
+                } //!< Metropolis criterion using a pre-drawn random number in [0:1[ (true=accept)
+
                 struct State {
                     Tspace spc;
                     Energy::Hamiltonian<Tspace> pot;
@@ -1499,23 +1805,199 @@ start:
                     }
                 }; //!< Contains everything to describe a state
 
-                State state1, // old state (accepted)
-                      state2; // new state (trial)
+                std::unique_ptr<State> oldstate; // old state (accepted); absent in single-state simulations
+                State state2; // new state (trial); the only state in single-state simulations
                 double uinit=0, dusum=0;
                 Average<double> uavg;
+                std::unique_ptr<WorkerThread> worker; //!< Evaluates old state energies concurrently with the trial state
+
+                struct Slot {
+                    State state;
+                    Move::Propagator<Tspace> moves;
+                    Slot(const json &j, MPI::MPIController &mpi) : state(j), moves(j, state.spc, state.pot, mpi) {}
+                }; //!< Scratch copy of the system and moves for speculative execution
+
+                struct Trial {
+                    Move::Movebase *mv=nullptr; //!< Attempted move; nullptr if none
+                    Change change;
+                    double du=0;
+                    bool accepted=false;
+                }; //!< Outcome of a speculative trial move
+
+                std::vector<std::unique_ptr<Slot>> slots; //!< Scratch copies; the first trial uses `state2` and `moves`
+                std::vector<Trial> trials;  //!< Outcome of each speculative trial in a round
+                unsigned int seedbase=0;    //!< Base seed for per-step random number streams
+                unsigned long long step=0;  //!< Number of completed speculative trial moves
+                unsigned long rounds=0, discarded=0; //!< Speculative execution statistics
+                bool speculative=false;     //!< True if trials are attempted by `moveSpeculative()`, also for K=1
+
+                State& slotState(size_t k) { return (k==0) ? state2 : slots[k-1]->state; }
+                Move::Propagator<Tspace>& slotMoves(size_t k) { return (k==0) ? moves : slots[k-1]->moves; }
+
+                State& state1() { return oldstate ? *oldstate : state2; } //!< Old (accepted) state
+                const State& state1() const { return oldstate ? *oldstate : state2; } //!< Old (accepted) state
+
+                static bool singleStateRequested(const json &j) {
+                    for (auto &m : j.at("energy"))
+                        if (m.count("singlestate")==1)
+                            return m["singlestate"].get<bool>();
+                    return false;
+                } //!< True if `singlestate` is set in the energy list
+
+                /*
+                 * Single-state move: the trial energy is evaluated first, then the move is undone
+                 * using the undo log of the (only) space and the old energy is evaluated.
+                 * The undo log is swapped back only if the move is accepted.
+                 */
+                double moveSingleState(Move::Movebase &mv, Change &change) {
+                    state2.pot.key = Energy::Energybase::NEW;
+                    double unew = state2.pot.energy(change);
+                    state2.spc.undo(change); // back to old state
+                    state2.pot.key = Energy::Energybase::OLD;
+                    double uold = state2.pot.energy(change);
+                    double du = Move::energyChange(uold, unew, unew - uold);
+                    double bias = mv.bias(change, uold, unew); // no ideal term as particle numbers are constant
+                    if ( metropolis(du + bias) ) {
+                        state2.spc.undo(change); // re-apply move
+                        mv.accept(change);
+                    } else {
+                        mv.reject(change);
+                        du=0;
+                    }
+                    state2.spc.commit();
+                    return du;
+                }
+
+                /*
+                 * Attempt trial move number `n` in slot `k`, starting from the current state. As in
+                 * `moveSingleState()`, the trial is undone after evaluating its energy, but here it is
+                 * re-applied by the caller only if it is the first accepted trial of the round.
+                 * Random numbers are drawn from a stream seeded by `n`, so the outcome does not depend on
+                 * the slot or thread. All numbers are drawn before the energy evaluation, during
+                 * which the thread may run other trials that re-seed the (thread local) generator.
+                 */
+                void attempt(size_t k, unsigned long long n) {
+                    auto &t = trials[k];
+                    auto &state = slotState(k);
+                    auto &propagator = slotMoves(k);
+                    std::seed_seq seq {seedbase, unsigned(n), unsigned(n>>32)};
+                    Move::Movebase::slump.engine.seed(seq);
+                    t.change.clear();
+                    t.accepted = false;
+                    t.du = 0;
+                    t.mv = nullptr;
+                    auto mv = propagator.sample();
+                    if (mv != propagator.end()) {
+                        t.mv = mv->get();
+                        t.mv->move(t.change);
+                        if (t.change) {
+                            double random = Move::Movebase::slump();
+                            state.spc.update(t.change);
+                            if (t.mv->sampled) { // always accepted
+                                t.du = t.mv->dusampled;
+                                t.accepted = true;
+                                state.spc.undo(t.change); // back to old state
+                                return;
+                            }
+                            state.pot.key = Energy::Energybase::NEW;
+                            double unew = state.pot.energy(t.change);
+                            state.spc.undo(t.change); // back to old state
+                            state.pot.key = Energy::Energybase::OLD;
+                            double uold = state.pot.energy(t.change);
+                            t.du = Move::energyChange(uold, unew, unew - uold);
+                            t.accepted = metropolis(t.du + t.mv->bias(t.change, uold, unew), random);
+                        }
+                    }
+                }
+
+                /*
+                 * Speculative execution: the next K trial moves are attempted concurrently on K copies
+                 * of the system, all starting from the current state as if the preceding trials were
+                 * rejected. The first accepted trial, in sequence order, is committed to all copies
+                 * while the trials following it are discarded and attempted again from the new state.
+                 * Since each trial draws from its own random number stream, the Markov chain is
+                 * identical to attempting the trials one by one, for any K.
+                 */
+                void moveSpeculative() {
+                    size_t K = slots.size()+1;
+                    int n = moves.repeat();
+                    while (n>0) {
+                        size_t m = std::min(K, size_t(n));
+                        threadPool().sum(m, [&](size_t k){ attempt(k, step+k); return 0.0; });
+                        rounds++;
+
+                        size_t first = m; // first accepted trial
+                        for (size_t k=0; k<m; k++)
+                            if (trials[k].accepted) {
+                                first = k;
+                                break;
+                            }
+
+                        for (size_t k=0; k<m; k++) {
+                            auto &t = trials[k];
+                            if (t.mv==nullptr)
+                                continue;
+                            if (k>first) {
+                                t.mv->discard(t.change);
+                                discarded++;
+                            } else if (t.change) {
+                                lastMoveName = t.mv->name;
+                                if (k==first) {
+                                    slotState(k).spc.undo(t.change); // re-apply move
+                                    t.mv->accept(t.change);
+                                    dusum += t.du;
+                                } else
+                                    t.mv->reject(t.change);
+                            }
+                        }
+
+                        for (size_t k=0; k<K; k++)
+                            slotState(k).spc.commit();
+                        if (first<m)
+                            for (size_t k=0; k<K; k++)
+                                if (k!=first)
+                                    slotState(k).sync( slotState(first), trials[first].change );
+
+                        size_t done = (first<m) ? first+1 : m;
+                        step += done;
+                        n -= done;
+                    }
+                }
 
                 void init() {
                     dusum=0;
                     Change c; c.all=true;
 
-                    state1.pot.key = Energy::Energybase::OLD; // this is the old energy (current, accepted)
+                    if (not oldstate) { // single state w. undo log
+                        state2.spc.undolog.enabled = true;
+                        state2.pot.key = Energy::Energybase::OLD;
+                        state2.spc.update(c);
+                        state2.pot.init();
+                        uinit = state2.pot.energy(c);
+
+                        trials.resize(slots.size()+1);
+                        for (auto &slot : slots) { // scratch copies of the system
+                            slot->state.spc.undolog.enabled = true;
+                            slot->state.pot.key = Energy::Energybase::OLD;
+                            slot->state.sync(state2, c);
+                            slot->state.pot.init();
+                        }
+                        if (speculative) {
+                            seedbase = Move::Movebase::slump.engine();
+                            step = 0;
+                        }
+                        return;
+                    }
+
+                    state1().pot.key = Energy::Energybase::OLD; // this is the old energy (current, accepted)
                     state2.pot.key = Energy::Energybase::NEW; // this is the new energy (trial)
 
-                    state1.pot.init();
-                    double u1 = state1.pot.energy(c);
+                    state1().spc.update(c);
+                    state1().pot.init();
+                    double u1 = state1().pot.energy(c);
                     uinit = u1;
 
-                    state2.sync(state1, c); // copy all information from state1 into state2
+                    state2.sync(state1(), c); // copy all information from state1 into state2
                     state2.pot.init();
                     double u2 = state2.pot.energy(c);
 
@@ -1531,23 +2013,23 @@ start:
                     for (auto base : moves.vec) {
                         auto derived = std::dynamic_pointer_cast<Move::SpeciationMove<Tspace>>(base);
                         if (derived)
-                            derived->setOther(state1.spc);
+                            derived->setOther(state1().spc);
                     }
                 }
 
             public:
                 Move::Propagator<Tspace> moves;
 
-                auto& pot() { return state1.pot; }
-                auto& space() { return state1.spc; }
-                const auto& pot() const { return state1.pot; }
-                const auto& space() const { return state1.spc; }
-                const auto& geometry() const { return state1.spc.geo; }
-                const auto& particles() const { return state1.spc.p; }
+                auto& pot() { return state1().pot; }
+                auto& space() { return state1().spc; }
+                const auto& pot() const { return state1().pot; }
+                const auto& space() const { return state1().spc; }
+                const auto& geometry() const { return state1().spc.geo; }
+                const auto& particles() const { return state1().spc.p; }
 
                 double drift() {
                     Change c; c.all=true;
-                    double ufinal = state1.pot.energy(c);
+                    double ufinal = state1().pot.energy(c);
                     double du = ufinal-uinit;
                     if (std::isfinite(du)) {
                         if (std::fabs(du)<1e-10) return 0;
@@ -1557,20 +2039,51 @@ start:
                     return std::numeric_limits<double>::quiet_NaN();
                 } //!< Calculates the relative energy drift from initial configuration
 
-                MCSimulation(const json &j, MPI::MPIController &mpi) : state1(j), state2(j), moves(j, state2.spc, mpi) {
+                MCSimulation(const json &j, MPI::MPIController &mpi) :
+                    oldstate( (singleStateRequested(j) or j.count("speculative")==1) ? nullptr : std::make_unique<State>(j) ),
+                    state2(j), moves(j, state2.spc, state2.pot, mpi) {
+
+                    if (not oldstate) { // single state requires that all energy terms and moves support undo
+                        std::vector<std::string> unsupported;
+                        for (auto &i : state2.pot.vec)
+                            if (not i->undoable)
+                                unsupported.push_back(i->name);
+                        for (auto &i : moves.vec)
+                            if (not i->undoable)
+                                unsupported.push_back(i->name);
+                        if (not unsupported.empty()) {
+                            std::cerr << "warning: single state unsupported by";
+                            for (auto &name : unsupported)
+                                std::cerr << " '" << name << "'";
+                            std::cerr << "; using two states" << std::endl;
+                            oldstate = std::make_unique<State>(j);
+                        }
+                    }
+                    if (j.count("speculative")==1) {
+                        if (oldstate)
+                            std::cerr << "warning: speculative execution requires a single state; disabled" << std::endl;
+                        else {
+                            speculative = true;
+                            for (int k=1; k<j.at("speculative").get<int>(); k++)
+                                slots.emplace_back( new Slot(j, mpi) );
+                        }
+                    }
                     init();
+                    if (state2.pot.isConcurrent())
+                        worker = std::make_unique<WorkerThread>();
                 }
 
 /* currently unused -- see Analysis::SaveState.
                 void store(json &j) const {
-                    j = state1.spc;
+                    j = state1().spc;
                     j["random-move"] = Move::Movebase::slump;
                     j["random-global"] = Faunus::random;
                 } // store system to json object
 */
                 void restore(const json &j) {
                     try {
-                        state1.spc = j; // old/accepted state
+                        if (oldstate)
+                            oldstate->spc = j; // old/accepted state
                         state2.spc = j; // trial state
                         Move::Movebase::slump = j["random-move"]; // restore move random number generator
                         Faunus::random = j["random-global"];      // restore global random number generator
@@ -1582,49 +2095,80 @@ start:
                 } //!< restore system from previously store json object
 
                 void move() {
+                    if (speculative)
+                        return moveSpeculative();
                     Change change;
                     for (int i=0; i<moves.repeat(); i++) {
                         auto mv = moves.sample(); // pick random move
                         if (mv != moves.end() ) {
                             change.clear();
+                            state2.spc.commit(); // start from an empty undo log
                             (**mv).move(change);
 
                             if (change) {
+                                state2.spc.update(change); // e.g. update structure-of-arrays mirror
                                 lastMoveName = (**mv).name; // store name of move for output
-                                double unew, uold, du;
-                                //#pragma omp parallel sections
-                                {
-                                    //#pragma omp section
-                                    { unew = state2.pot.energy(change); }
-                                    //#pragma omp section
-                                    { uold = state1.pot.energy(change); }
-                                }
 
-                                du = unew - uold;
+                                if ((**mv).sampled) { // trials have already been accepted or rejected
+                                    if (oldstate)
+                                        state1().sync( state2, change );
+                                    (**mv).accept(change);
+                                    dusum += (**mv).dusampled;
+                                    continue;
+                                }
 
-                                // if any energy returns NaN (from i.e. division by zero), the
-                                // configuration will always be rejected, or if moving from NaN
-                                // to a finite energy, always accepted.
+                                if (not oldstate) {
+                                    dusum += moveSingleState(**mv, change);
+                                    continue;
+                                }
 
-                                if (std::isnan(uold) and not std::isnan(unew))
-                                    du = -pc::infty; // accept
-                                else if (std::isnan(unew))
-                                    du = pc::infty; // reject
+                                double unew=0, uold=0, du=0, bias=0, random=0;
+
+                                // early rejection: with the Metropolis random number drawn up front, the move
+                                // is rejected if du > -ln(random) - bias so energy terms can be skipped once
+                                // the partial sum exceeds this threshold
+                                bool early = state2.pot.isEarlyReject() and not (**mv).energybias;
+                                bool single = early or state2.pot.isFused(); // energy change from delta()
+
+                                // fused single pass evaluation of the energy change; NaN cannot
+                                // be attributed to either state so such moves are re-evaluated below
+                                if (early) {
+                                    random = Move::Movebase::slump();
+                                    bias = (**mv).bias(change, 0, 0) + IdealTerm( state2.spc, state1().spc , change);
+                                    unew = du = state2.pot.delta(change, &state1().pot, -std::log(random) - bias);
+                                } else if (single)
+                                    unew = du = state2.pot.delta(change, &state1().pot);
+
+                                if (not single or std::isnan(du)) {
+                                    if (worker) {
+                                        // terms marked as safe run in both states at the same time; the rest serially
+                                        auto mask = state2.pot.concurrentMask();
+                                        if (std::find(mask.begin(), mask.end(), true) != mask.end()) {
+                                            worker->run( [&]{ uold = state1().pot.energy(change, mask, true); } );
+                                            unew = state2.pot.energy(change, mask, true);
+                                            worker->wait();
+                                        } else
+                                            unew = uold = 0;
+                                        unew += state2.pot.energy(change, mask, false);
+                                        uold += state1().pot.energy(change, mask, false);
+                                    } else {
+                                        unew = state2.pot.energy(change);
+                                        uold = state1().pot.energy(change);
+                                    }
 
-                                // if the difference in energy is NaN (from i.e. infinity minus infinity), the
-                                // configuration will always be accepted. This should be
-                                // noted during equilibration.
+                                    du = unew - uold;
+                                }
 
-                                else if (std::isnan(du))
-                                    du = 0; // accept
+                                du = Move::energyChange(uold, unew, du);
 
-                                double bias = (**mv).bias(change, uold, unew) + IdealTerm( state2.spc, state1.spc , change);
+                                if (not early)
+                                    bias = (**mv).bias(change, uold, unew) + IdealTerm( state2.spc, state1().spc , change);
 
-                                if ( metropolis(du + bias) ) { // accept move
-                                    state1.sync( state2, change );
+                                if ( early ? metropolis(du + bias, random) : metropolis(du + bias) ) { // accept move
+                                    state1().sync( state2, change );
                                     (**mv).accept(change);
                                 } else { // reject move
-                                    state2.sync( state1, change );
+                                    state2.sync( state1(), change );
                                     (**mv).reject(change);
                                     du=0;
                                 }
@@ -1635,10 +2179,25 @@ start:
                 }
 
                 void to_json(json &j) {
-                    j = state1.spc.info();
+                    j = state1().spc.info();
                     j["temperature"] = pc::temperature / 1.0_K;
                     j["moves"] = moves;
-                    j["energy"].push_back(state1.pot);
+                    if (speculative) { // move statistics are spread over all slots
+                        for (size_t i=0; i<moves.vec.size(); i++) {
+                            unsigned long cnt=0, accepted=0;
+                            for (size_t k=0; k<=slots.size(); k++) {
+                                cnt += slotMoves(k).vec[i]->trials();
+                                accepted += slotMoves(k).vec[i]->acceptedTrials();
+                            }
+                            auto &_j = j["moves"][i][moves.vec[i]->name];
+                            _j["moves"] = cnt;
+                            _j["acceptance"] = double(accepted)/cnt;
+                        }
+                        j["speculative"] = {
+                            {"slots", slots.size()+1}, {"rounds", rounds}, {"discarded", discarded},
+                            {"trials per round", (rounds>0) ? double(step)/rounds : 0} };
+                    }
+                    j["energy"].push_back(state1().pot);
                     j["last move"] = lastMoveName;
                 }
         };
@@ -1648,6 +2207,57 @@ start:
             mc.to_json(j);
         }
 
+#ifdef DOCTEST_LIBRARY_INCLUDED
+    TEST_CASE("[Faunus] MCSimulation - speculative execution")
+    {
+        typedef Particle<Charge> Tparticle;
+        typedef std::vector<Tparticle> Tpvec;
+
+        json j = R"({
+            "atomlist": [
+                {"Na": {"q": 1.0, "sigma": 4.0, "eps": 0.15, "dp": 3.0}},
+                {"Cl": {"q": -1.0, "sigma": 4.0, "eps": 0.15, "dp": 3.0}} ],
+            "moleculelist": [ {"salt": {"atoms": ["Na", "Cl"], "atomic": true}} ],
+            "insertmolecules": [ {"salt": {"N": 20}} ],
+            "energy": [
+                {"nonbonded": {"default": [
+                    {"lennardjones": {"mixing": "LB"}},
+                    {"coulomb": {"type": "plain", "epsr": 80, "cutoff": 10}} ]}},
+                {"singlestate": true} ],
+            "moves": [ {"transrot": {"molecule": "salt"}} ],
+            "geometry": {"type": "cuboid", "length": 25} })"_json;
+
+        atoms = j["atomlist"].get<decltype(atoms)>();
+        molecules<Tpvec> = j["moleculelist"].get<decltype(molecules<Tpvec>)>();
+
+        auto random0 = Faunus::random;
+        auto slump0 = Move::Movebase::slump;
+        auto run = [&](int K) {
+            Faunus::random = random0; // same initial configuration...
+            Move::Movebase::slump = slump0; // ...and random number streams
+            j["speculative"] = K;
+            MCSimulation<Geometry::Chameleon, Tparticle> sim(j, MPI::mpi);
+            Tpvec p0 = sim.particles();
+            for (int n=0; n<100; n++)
+                sim.move();
+            int moved=0;
+            for (size_t i=0; i<p0.size(); i++)
+                moved += (p0[i].pos != sim.particles()[i].pos);
+            CHECK( moved>0 );
+            Change all;
+            all.all = true;
+            CHECK( sim.drift() == doctest::Approx(0) );
+            return std::make_pair( sim.particles(), sim.pot().energy(all) );
+        };
+
+        auto one = run(1), four = run(4);
+        REQUIRE( one.first.size()==four.first.size() );
+        for (size_t i=0; i<one.first.size(); i++)
+            CHECK( (one.first[i].pos - four.first[i].pos).norm() < 1e-12 );
+        CHECK( one.second == doctest::Approx(four.second) );
+    }
+#endif
+
     /**
      * @brief Ideal energy contribution of a speciation move
      * This funciton calculates the contribution to the energy change arising from the
@@ -1657,7 +2267,10 @@ start:
      *     \beta \Delta U = - \sum \ln ( N_o!/N_n! V^{N_n - N_o} )
      * @f]
      *
-     * where the sum runs over all products and reactants.
+     * where the sum runs over all products and reactants. Each touched atom type
+     * (swap moves), atomic molecule, and molecule type is counted once using the
+     * active counts maintained by `Space`, so the cost is independent of the
+     * number of particles and groups.
      *
      * @todo
      * - use exception message to suggest how to fix the problem
@@ -1667,62 +2280,38 @@ start:
             using Tpvec = typename Tspace::Tpvec;
             double NoverO=0;
             if ( change.dN ) { // Has the number of any molecules changed?
+                double lnV = std::log( spc_n.geo.getVolume() * 1.0_molar );
+                auto ideal = [lnV](int N_n, int N_o) {
+                    return std::lgamma(N_n + 1.0) - std::lgamma(N_o + 1.0) - (N_n - N_o) * lnV;
+                }; // ln[ N_n! / N_o! / (V c)^(N_n-N_o) ]
+
+                std::vector<int> atomids, atomicgroups, molids; // touched species
                 for ( auto &m : change.groups ) {
-                    int N_o = 0;
-                    int N_n = 0;
+                    auto &g_n = spc_n.groups.at(m.index);
                     if ( m.dNswap ) {
                         assert( m.atoms.size()==1 );
-                        auto &g_n = spc_n.groups.at(m.index);
-                        int id1 = (g_n.begin()+m.atoms.front())->id;
                         auto &g_o = spc_o.groups.at(m.index);
-                        int id2 = (g_o.begin()+m.atoms.front())->id;
-                        for (int id : {id1, id2}) {
-                            auto atomlist_n = spc_n.findAtoms(id);
-                            auto atomlist_o = spc_o.findAtoms(id);
-                            N_n = size(atomlist_n);
-                            N_o = size(atomlist_o);
-                            int dN = N_n - N_o;
-                            double V_n = spc_n.geo.getVolume();
-                            if (dN>0)
-                                for (int n=0; n < dN; n++)
-                                    NoverO += std::log( (N_o + 1 + n) / ( V_n * 1.0_molar ));
-                            else 
-                                for (int n=0; n < (-dN); n++)
-                                    NoverO -= std::log( (N_o - n) / ( V_n * 1.0_molar ));
-                        }
-                    } else {
-                        if ( m.dNatomic ) {
-                            auto mollist_n = spc_n.findMolecules(spc_n.groups[m.index].id, Tspace::ALL);
-                            auto mollist_o = spc_o.findMolecules(spc_o.groups[m.index].id, Tspace::ALL);
-                            if ( size(mollist_n) > 1 || size(mollist_o) > 1 )
-                                throw std::runtime_error("Bad definition: One group per atomic molecule!");
-                            if ( not molecules<Tpvec>[ spc_n.groups[m.index].id ].atomic)
-                                throw std::runtime_error("Only atomic molecules!");
-                            // Below is safe due to the catches above
-                            // add consistency criteria with m.atoms.size() == N
-                            N_n =  mollist_n.begin()->size();
-                            N_o =  mollist_o.begin()->size();
-                        } else {
-                            if ( not molecules<Tpvec>[ spc_n.groups[m.index].id ].atomic ) { // Molecular species
-                                auto mollist_n = spc_n.findMolecules(m.index, Tspace::ACTIVE);
-                                auto mollist_o = spc_o.findMolecules(m.index, Tspace::ACTIVE);
-                                N_n=size(mollist_n);
-                                N_o=size(mollist_o);
-                            }
-                        }
-                        int dN = N_n - N_o;
-                        if (dN!=0) {
-                            double V_n = spc_n.geo.getVolume();
-                            //double V_o = spc_o.geo.getVolume();
-                            if (dN>0)
-                                for (int n=0; n < dN; n++)
-                                    NoverO += std::log( (N_o + 1 + n) / ( V_n * 1.0_molar ));
-                            else 
-                                for (int n=0; n < (-dN); n++)
-                                    NoverO -= std::log( (N_o - n) / ( V_n * 1.0_molar ));
-                        }
-                    }
+                        atomids.push_back( (g_n.begin()+m.atoms.front())->id );
+                        atomids.push_back( (g_o.begin()+m.atoms.front())->id );
+                    } else if ( m.dNatomic ) {
+                        if ( spc_n.numMolecules(g_n.id, Tspace::ALL) > 1 || spc_o.numMolecules(g_n.id, Tspace::ALL) > 1 )
+                            throw std::runtime_error("Bad definition: One group per atomic molecule!");
+                        if ( not molecules<Tpvec>[ g_n.id ].atomic)
+                            throw std::runtime_error("Only atomic molecules!");
+                        atomicgroups.push_back( m.index );
+                    } else if ( not molecules<Tpvec>[ g_n.id ].atomic ) // Molecular species
+                        molids.push_back( g_n.id );
+                }
+                for (auto v : {&atomids, &atomicgroups, &molids}) { // count each species once
+                    std::sort( v->begin(), v->end() );
+                    v->erase( std::unique(v->begin(), v->end()), v->end() );
                 }
+                for (int id : atomids)
+                    NoverO += ideal( spc_n.numAtoms(id), spc_o.numAtoms(id) );
+                for (int i : atomicgroups)
+                    NoverO += ideal( spc_n.groups[i].size(), spc_o.groups[i].size() );
+                for (int molid : molids)
+                    NoverO += ideal( spc_n.numMolecules(molid), spc_o.numMolecules(molid) );
             }
             return NoverO; // negative sign since Pref exp{-beta(dU)} = exp{-beta(dU -ln(Pref)}
         }
@@ -68,6 +68,15 @@ namespace Faunus {
             return sum;
         }
 
+        std::string broadcast(MPIController &mpi, const std::string &s) {
+            int size = s.size();
+            MPI_Bcast(&size, 1, MPI_INT, mpi.rankMaster(), mpi.comm);
+            std::string buf = s;
+            buf.resize(size);
+            MPI_Bcast(&buf[0], size, MPI_CHAR, mpi.rankMaster(), mpi.comm);
+            return buf;
+        }
+
         FloatTransmitter::FloatTransmitter() {
             tag=0;
         }
@@ -102,6 +102,13 @@ namespace Faunus {
          */
         double reduceDouble(MPIController &mpi, double local);
 
+        /**
+         * @brief Broadcast string from master to all ranks
+         *
+         * The argument is ignored on all ranks but the master.
+         */
+        std::string broadcast(MPIController &mpi, const std::string &s);
+
         /*!
          * \brief Class for transmitting floating point arrays over MPI
          * \note If you change the floatp typedef, remember also to change to change to/from
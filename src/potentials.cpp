@@ -129,6 +129,7 @@ void Faunus::Potential::CoulombGalore::from_json(const Faunus::json &j) {
         depsdt = j.value("depsdt", -0.368*pc::temperature/epsr);
         sf.setTolerance(
                 j.value("utol",1e-5),j.value("ftol",1e-2) );
+        sf.setMethod( j.value("tabulator", std::string("andrea")) );
 
         if (type=="reactionfield") sfReactionField(j);
         if (type=="fanourgakis") sfFanourgakis(j);
@@ -137,7 +138,7 @@ void Faunus::Potential::CoulombGalore::from_json(const Faunus::json &j) {
         if (type=="yukawa") sfYukawa(j);
         if (type=="fennel") sfFennel(j);
         if (type=="plain") sfPlain(j,1);
-        if (type=="ewald") sfEwald(j);
+        if (type=="ewald" || type=="spme") sfEwald(j);
         if (type=="none") sfPlain(j,0);
         if (type=="wolf") sfWolf(j);
         if ( table.empty() )
@@ -161,13 +162,14 @@ void Faunus::Potential::CoulombGalore::to_json(Faunus::json &j) const {
     j["lB"] = lB;
     j["cutoff"] = rc;
     j["type"] = type;
+    j["tabulator"] = sf.method();
     if (type=="yukawa") {
         j["debyelength"] = 1.0/kappa;
         j["ionic strength"] = I;
     }
     if (type=="qpotential")
         j["order"] = order;
-    if (type=="yonezawa" || type=="fennel" || type=="wolf" || type=="ewald")
+    if (type=="yonezawa" || type=="fennel" || type=="wolf" || type=="ewald" || type=="spme")
         j["alpha"] = alpha;
     if (type=="reactionfield") {
         if(epsrf > 1e10)
@@ -218,6 +220,10 @@ void Faunus::Potential::to_json(Faunus::json &j, const std::shared_ptr<Faunus::P
     json val;
     b->to_json(val);
     val["index"] = b->index;
+    if (b->exclude) {
+        val["exclude"] = true;
+        val["keepelectrostatics"] = b->keepelectrostatics;
+    }
     j = {{ b->name(), val }};
 }
 
@@ -236,6 +242,8 @@ void Faunus::Potential::from_json(const Faunus::json &j, std::shared_ptr<Faunus:
             try {
                 b->from_json( val );
                 b->index = val.at("index").get<decltype(b->index)>();
+                b->exclude = val.value("exclude", false);
+                b->keepelectrostatics = val.value("keepelectrostatics", true);
                 if (b->index.size() != b->numindex())
                     throw std::runtime_error("exactly " + std::to_string(b->numindex()) + " indices required for " + b->name());
             } catch (std::exception &e) {
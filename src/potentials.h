@@ -17,6 +17,8 @@ namespace Faunus {
             std::string cite;
             virtual void to_json(json&) const=0;
             virtual void from_json(const json&)=0;
+            virtual double cutoff2() const { return pc::infty; } //!< Squared distance beyond which the energy is zero for all atom pairs
+            virtual bool threadsafe() const { return true; } //!< True if the energy can be evaluated by several threads at once
             virtual ~PairPotentialBase();
         }; //!< Base for all pair-potentials
 
@@ -52,6 +54,8 @@ namespace Faunus {
                 }
 
                 void to_json(json &j) const override { j = {first,second}; }
+                double cutoff2() const override { return std::max(first.cutoff2(), second.cutoff2()); }
+                bool threadsafe() const override { return first.threadsafe() and second.threadsafe(); }
             };
 
         template<class T1, class T2,
@@ -69,6 +73,7 @@ namespace Faunus {
                 }
             void from_json(const json&) override {}
             void to_json(json&) const override {}
+            double cutoff2() const override { return 0; }
         }; //!< A dummy pair potential that always returns zero
 
         template<typename Tparticle>
@@ -168,6 +173,8 @@ namespace Faunus {
                             return m->eps(a.id,b.id) * (x*x - x);
                         }
 
+                    const SigmaEpsilonTable<Tparticle>& mixing() const { return *m; } //!< Table w. sigma_ij^2 and 4xepsilon
+
                     void to_json(json &j) const override { j = *m; }
                     void from_json(const json &j) override { *m = j; }
             };
@@ -221,6 +228,14 @@ namespace Faunus {
                             x=x*x*x;// (s/r)^6
                             return m->eps(a.id,b.id)*6*(2*x*x - x)/r2*p;
                         }
+
+                    double cutoff2() const override {
+                        double s2=0;
+                        for (size_t i=0; i<m->s2.size(); i++)
+                            for (size_t j=0; j<m->s2.size(); j++)
+                                s2 = std::max(s2, m->s2(i,j));
+                        return s2*twototwosixth;
+                    }
             }; // Weeks-Chandler-Andersen potential
 
         /**
@@ -280,6 +295,14 @@ namespace Faunus {
                     double operator()(const Tparticle &a, const Tparticle &b, const Point &r) const {
                         return r.squaredNorm() < d2->operator()(a.id,b.id) ? pc::infty : 0;
                     }
+                    const PairMatrix<double>& contact2() const { return *d2; } //!< Matrix w. squared contact distances
+                    double cutoff2() const override {
+                        double c2=0;
+                        for (size_t i=0; i<d2->size(); i++)
+                            for (size_t j=0; j<d2->size(); j++)
+                                c2 = std::max(c2, d2->operator()(i,j));
+                        return c2;
+                    }
                     void to_json(json&) const override {}
                     void from_json(const json&) override {}
             }; //!< Hardsphere potential
@@ -359,6 +382,7 @@ namespace Faunus {
 
             void to_json(json &j) const override;
             void from_json(const json &j) override;
+            double cutoff2() const override { return rcwc2; }
         };
 
         /**
@@ -660,7 +684,7 @@ namespace Faunus {
 
         /** @brief Coulomb type potentials with spherical cutoff */
         class CoulombGalore : public PairPotentialBase {
-            Tabulate::Andrea<double> sf; // splitting function
+            Tabulate::Tabulator<double> sf; // splitting function
             Tabulate::TabulatorBase<double>::data table; // data for splitting function
             std::function<double(double)> calcDielectric; // function for dielectric const. calc.
             std::string type;
@@ -720,10 +744,42 @@ namespace Faunus {
                 }
 
             double dielectric_constant(double M2V);
+            double bjerrumLength() const { return lB; } //!< Bjerrum length
+            double cutoff() const { return rc; } //!< Spherical cutoff
+            double cutoff2() const override { return rc2; }
+            const Tabulate::TabulatorBase<double>::data& splitting() const { return table; } //!< Splitting function spline in q=r/Rc
 
             void to_json(json &j) const override;
         };
 
+        /**
+         * @brief Electrostatic part of a pair potential
+         *
+         * Used for excluded atom pairs that keep electrostatic interactions
+         * (see `ExclusionList`). Overloads exist for `Coulomb`, `CoulombGalore`,
+         * `FunctorPotential`, and combined potentials; all other potentials
+         * have no electrostatic part.
+         */
+        template<class Tpairpot, class Tparticle>
+            double electrostatic(const Tpairpot&, const Tparticle&, const Tparticle&, const Point&) {
+                return 0;
+            }
+
+        template<class Tparticle>
+            double electrostatic(const Coulomb &pot, const Tparticle &a, const Tparticle &b, const Point &r) {
+                return pot(a, b, r);
+            }
+
+        template<class Tparticle>
+            double electrostatic(const CoulombGalore &pot, const Tparticle &a, const Tparticle &b, const Point &r) {
+                return pot(a, b, r);
+            }
+
+        template<class T1, class T2, class Tparticle>
+            double electrostatic(const CombinedPairPotential<T1,T2> &pot, const Tparticle &a, const Tparticle &b, const Point &r) {
+                return electrostatic(pot.first, a, b, r) + electrostatic(pot.second, a, b, r);
+            }
+
         /**
          * @brief Custom pair-potential taking math. expressions at runtime
          */
@@ -752,6 +808,8 @@ namespace Faunus {
                 CustomPairPotential(const std::string &name="custom");
                 void from_json(const json&) override;
                 void to_json(json&) const override;
+                double cutoff2() const override { return Rc2; }
+                bool threadsafe() const override { return false; } // arguments are passed via shared `Data`
         };
 
 #ifdef DOCTEST_LIBRARY_INCLUDED
@@ -780,76 +838,106 @@ namespace Faunus {
         /**
          * @brief Arbitrary potentials for specific atom types
          *
-         * This maintains a species x species matrix with function pointers (`std::function`)
-         * that wraps pair potentials. Flexibility over performance.
+         * Pair potentials given for each atom pair are instantiated once and
+         * stored by type. Each atom pair refers to a contiguous range of
+         * evaluators, `(type, index)`, in a flat table and the energy is the
+         * sum of these, dispatched by a `switch` on the type which allows the
+         * compiler to inline the concrete potentials.
+         * Within `[rmin,rmax]` the sum is tabulated.
          *
          * @todo `to_json` should retrieve info from potentials instead of merely passing input
-         * @warning Each atom pair will be assigned an instance of a pair-potential. This *could* be
-         *          problematic if these have large memory requirements.
          */
         template<class T /** particle type */>
             class FunctorPotential : public PairPotentialBase {
-                typedef std::function<double(const T&, const T&, const Point&)> uFunc;
-                PairMatrix<uFunc,true> umatrix; // matrix with potential for each atom pair
                 typedef Tabulate::TabulatorBase<double>::data Ttable; // data for tabulated potential
-                Tabulate::Andrea<double> tblt; // tabulated potential
+                Tabulate::Tabulator<double> tblt; // tabulated potential
                 PairMatrix<Ttable,true> tmatrix; // matrix with tabulated potential for each atom pair
                 json _j; // storage for input json
                 double rc2;
                 typedef CombinedPairPotential<Coulomb,HardSphere<T>> PrimitiveModel;
                 typedef CombinedPairPotential<Coulomb,WeeksChandlerAndersen<T>> PrimitiveModelWCA;
 
-                // List of pair-potential instances used when constructing functors.
-                // Note that potentials w. large memory requirements (LJ, WCA etc.)
-                // typically use `shared_ptr` so that the created functors _share_
-                // the data. That is *only* put the pair-potential here if you can
-                // share internal (shared) pointers.
+                enum Type {COULOMB=0, COS2, POLAR, HARDSPHERE, LENNARDJONES, REPULSIONR3, SASA, WCA, PM, PMWCA, CUSTOM};
+
+                // Instances of pair-potentials, one vector for each `Type` (same order)
                 std::tuple<
-                    CoulombGalore,    // 0
-                    CosAttract,       // 1
-                    Polarizability<T>,// 2
-                    HardSphere<T>,    // 3
-                    LennardJones<T>,  // 4
-                    RepulsionR3,      // 5
-                    SASApotential,    // 6
-                    WeeksChandlerAndersen<T>,// 7
-                    PrimitiveModel,   // 8
-                    PrimitiveModelWCA // 9
-                        > potlist;
-
-                 uFunc combineFunc(const json &j) { 
-                    uFunc u = [](const T&, const T&, const Point&){return 0.0;};
+                    std::vector<CoulombGalore>,
+                    std::vector<CosAttract>,
+                    std::vector<Polarizability<T>>,
+                    std::vector<HardSphere<T>>,
+                    std::vector<LennardJones<T>>,
+                    std::vector<RepulsionR3>,
+                    std::vector<SASApotential>,
+                    std::vector<WeeksChandlerAndersen<T>>,
+                    std::vector<PrimitiveModel>,
+                    std::vector<PrimitiveModelWCA>,
+                    std::vector<CustomPairPotential>
+                        > potentials;
+
+                struct Evaluator {
+                    Type type;
+                    int index; // index in vector of `type` in `potentials`
+                };
+
+                std::vector<Evaluator> evaluators; // evaluators for all atom pairs
+                std::vector<std::pair<int,int>> pairs; // range in `evaluators` for each atom pair (ntypes x ntypes)
+                size_t ntypes=0;
+
+                template<Type type>
+                    void add(const json &j) {
+                        auto &v = std::get<type>(potentials);
+                        v.emplace_back();
+                        v.back() = j;
+                        evaluators.push_back( {type, int(v.size())-1} );
+                    } //!< Instantiate pair-potential from json and add evaluator
+
+                std::pair<int,int> combine(const json &j) {
+                    int first = evaluators.size();
                     if (j.is_array()) {
                         for (auto &i : j) // loop over all defined potentials in array
                             if (i.is_object() and (i.size()==1))
                                 for (auto it : i.items()) {
-                                    uFunc _u = nullptr;
+                                    size_t size = evaluators.size();
                                     try {
-                                        if (it.key()=="custom") _u = CustomPairPotential() = it.value();
-                                        else if (it.key()=="coulomb") _u = std::get<0>(potlist) = i;
-                                        else if (it.key()=="cos2") _u = std::get<1>(potlist) = i;
-                                        else if (it.key()=="polar") _u = std::get<2>(potlist) = i;
-                                        else if (it.key()=="hardsphere") _u = std::get<3>(potlist) = i;
-                                        else if (it.key()=="lennardjones") _u = std::get<4>(potlist) = i;
-                                        else if (it.key()=="repulsionr3") _u = std::get<5>(potlist) = i;
-                                        else if (it.key()=="sasa") _u = std::get<6>(potlist) = i;
-                                        else if (it.key()=="wca") _u = std::get<7>(potlist) = i;
-                                        else if (it.key()=="pm") _u = std::get<8>(potlist) = it.value();
-                                        else if (it.key()=="pmwca") _u = std::get<9>(potlist) = it.value();
+                                        if (it.key()=="custom") add<CUSTOM>(it.value());
+                                        else if (it.key()=="coulomb") add<COULOMB>(i);
+                                        else if (it.key()=="cos2") add<COS2>(i);
+                                        else if (it.key()=="polar") add<POLAR>(i);
+                                        else if (it.key()=="hardsphere") add<HARDSPHERE>(i);
+                                        else if (it.key()=="lennardjones") add<LENNARDJONES>(i);
+                                        else if (it.key()=="repulsionr3") add<REPULSIONR3>(i);
+                                        else if (it.key()=="sasa") add<SASA>(i);
+                                        else if (it.key()=="wca") add<WCA>(i);
+                                        else if (it.key()=="pm") add<PM>(it.value());
+                                        else if (it.key()=="pmwca") add<PMWCA>(it.value());
                                         // place additional potentials here...
                                     } catch (std::exception &e) {
                                         throw std::runtime_error("Error adding energy '" + it.key() + "': " + e.what() + usageTip[it.key()]);
                                     }
-
-                                    if (_u!=nullptr) // if found, sum them into new function object
-                                        u = [u,_u](const T&a, const T&b, const Point &r){return u(a,b,r)+_u(a,b,r);};
-                                    else
+                                    if (evaluators.size()==size)
                                         throw std::runtime_error("unknown pair-potential: " + it.key());
                                 }
                     } else
                         throw std::runtime_error("dictionary of potentials required");
-                    return u;
-                } // parse json array of potentials to a single potential function object
+                    return {first, int(evaluators.size())};
+                } // parse json array of potentials to a range of evaluators
+
+                inline double evaluate(const Evaluator &e, const T &a, const T &b, const Point &r) const {
+                    switch (e.type) {
+                        case COULOMB: return std::get<COULOMB>(potentials)[e.index](a, b, r);
+                        case COS2: return std::get<COS2>(potentials)[e.index](a, b, r);
+                        case POLAR: return std::get<POLAR>(potentials)[e.index](a, b, r);
+                        case HARDSPHERE: return std::get<HARDSPHERE>(potentials)[e.index](a, b, r);
+                        case LENNARDJONES: return std::get<LENNARDJONES>(potentials)[e.index](a, b, r);
+                        case REPULSIONR3: return std::get<REPULSIONR3>(potentials)[e.index](a, b, r);
+                        case SASA: return std::get<SASA>(potentials)[e.index](a, b, r);
+                        case WCA: return std::get<WCA>(potentials)[e.index](a, b, r);
+                        case PM: return std::get<PM>(potentials)[e.index](a, b, r);
+                        case PMWCA: return std::get<PMWCA>(potentials)[e.index](a, b, r);
+                        case CUSTOM: return std::get<CUSTOM>(potentials)[e.index](a, b, r);
+                    }
+                    return 0;
+                } //!< Energy of a single evaluator
 
                 public:
 
@@ -857,28 +945,63 @@ namespace Faunus {
                     PairPotentialBase::name = name;
                 }
 
+                double evaluate(const T &a, const T &b, const Point &r) const {
+                    double u=0;
+                    auto &range = pairs[a.id*ntypes + b.id];
+                    for (int i=range.first; i<range.second; i++)
+                        u += evaluate(evaluators[i], a, b, r);
+                    return u;
+                } //!< Untabulated energy
+
+                double electrostatic(const T &a, const T &b, const Point &r) const {
+                    double u=0;
+                    auto &range = pairs[a.id*ntypes + b.id];
+                    for (int i=range.first; i<range.second; i++) {
+                        auto &e = evaluators[i];
+                        switch (e.type) {
+                            case COULOMB: u += std::get<COULOMB>(potentials)[e.index](a, b, r); break;
+                            case PM: u += std::get<PM>(potentials)[e.index].first(a, b, r); break;
+                            case PMWCA: u += std::get<PMWCA>(potentials)[e.index].first(a, b, r); break;
+                            default: break;
+                        }
+                    }
+                    return u;
+                } //!< Untabulated electrostatic energy (`coulomb`, `pm`, `pmwca`)
+
                 double operator()(const T &a, const T &b, const Point &r) const {
                     double r2 = r.squaredNorm();
-                    if (r2 > tmatrix(a.id, b.id).rmax2)
+                    auto &table = tmatrix(a.id, b.id);
+                    if (r2 > table.rmax2)
                         return 0.0;
-                    else if (r2 <= tmatrix(a.id, b.id).rmin2)
-                        return umatrix(a.id, b.id)(a, b, Point(0,0,sqrt(r2))); // pc::infty;
-                    else 
-                        return tblt.eval(tmatrix(a.id, b.id), r2);
+                    else if (r2 <= table.rmin2)
+                        return evaluate(a, b, Point(0,0,sqrt(r2)));
+                    else
+                        return tblt.eval(table, r2);
                 }
 
                 void to_json(json &j) const override { j = _j; }
 
+                double cutoff2() const override { return rc2; } // largest tabulated distance
+
+                bool threadsafe() const override {
+                    return std::get<CUSTOM>(potentials).empty();
+                } //!< Custom potentials are evaluated below the tabulated range and are not thread safe
+
                 void from_json(const json &j) override {
                     tblt.setTolerance(j.value("utol",1e-5),j.value("ftol",1e-2) );
+                    tblt.setMethod(j.value("tabulator", "andrea"s));
                     _j = j;
+                    rc2 = 0;
                     double rmax2 = pc::Nav;
-                    umatrix = decltype(umatrix)( atoms.size(), combineFunc(j.at("default")) );
+                    potentials = decltype(potentials)();
+                    evaluators.clear();
+                    ntypes = atoms.size();
+                    pairs.assign( ntypes*ntypes, combine(j.at("default")) );
                     for (auto it=j.begin(); it!=j.end(); ++it) {
                         auto atompair = words2vec<std::string>(it.key()); // is this for a pair of atoms?
                         if (atompair.size()==2) {
                             auto ids = names2ids(atoms, atompair);
-                            umatrix.set(ids[0], ids[1], combineFunc(it.value()));
+                            pairs[ids[0]*ntypes + ids[1]] = pairs[ids[1]*ntypes + ids[0]] = combine(it.value());
                         }
                     }
                     for (size_t i=0; i<atoms.size(); ++i) {
@@ -889,31 +1012,34 @@ namespace Faunus {
                                 double rmin2 = .5*(atoms[i].sigma + atoms[k].sigma);
                                 rmin2 = rmin2*rmin2;
                                 auto it = j.find("cutoff_g2g");
-                                if (it->is_number())
-                                    rmax2 = std::pow( it->get<double>(), 2 );
-                                else if (it->is_object())
-                                    rmax2 = std::pow( it->at("default").get<double>(), 2);
+                                if (it != j.end()) {
+                                    if (it->is_number())
+                                        rmax2 = std::pow( it->get<double>(), 2 );
+                                    else if (it->is_object())
+                                        rmax2 = std::pow( it->at("default").get<double>(), 2);
+                                }
                                 while (rmin2 >= 1e-2) {
-                                    if (abs(umatrix(i,k)(a, b, Point(0,0,sqrt(rmin2)))) > 1e6)
+                                    if (abs(evaluate(a, b, Point(0,0,sqrt(rmin2)))) > 1e6)
                                         rmin2 = rmin2 + 1e-2;
-                                    else if (abs(umatrix(i,k)(a, b, Point(0,0,sqrt(rmin2)))) > 1e5)
+                                    else if (abs(evaluate(a, b, Point(0,0,sqrt(rmin2)))) > 1e5)
                                         break;
                                     else
                                         rmin2 = rmin2 - 1e-2;
                                 }
                                 while (rmax2 >= 1e-2) {
-                                    if (abs(umatrix(i,k)(a, b, Point(0,0,sqrt(rmax2)))) > pc::epsilon_dbl)
+                                    if (abs(evaluate(a, b, Point(0,0,sqrt(rmax2)))) > pc::epsilon_dbl)
                                         break;
                                     rmax2 = rmax2 - 1e-2;
                                 }
-                                Ttable knotdata = tblt.generate( [&](double r2) { return umatrix(i,k)(a, b, Point(0,0,sqrt(r2))); }, rmin2, rmax2);
+                                Ttable knotdata = tblt.generate( [&](double r2) { return evaluate(a, b, Point(0,0,sqrt(r2))); }, rmin2, rmax2);
                                 tmatrix.set(i, k, knotdata);
+                                rc2 = std::max(rc2, rmax2);
                                 std::ofstream file(atoms[i].name+"-"+atoms[k].name+"_tabulated.dat"); // output file
                                 file << "# Separation\tTabulated\tOriginal\n";
                                 double r2 = rmin2;
                                 while (r2 < rmax2) {
                                     r2 = r2 + 1e-2;
-                                    file << sqrt(r2) << "\t" << tblt.eval(tmatrix(i, k), r2) << "\t" << umatrix(i,k)(a, b, Point(0,0,sqrt(r2))) << "\n";
+                                    file << sqrt(r2) << "\t" << tblt.eval(tmatrix(i, k), r2) << "\t" << evaluate(a, b, Point(0,0,sqrt(r2))) << "\n";
                                 }
                             }
                         }
@@ -921,6 +1047,11 @@ namespace Faunus {
                 }
             };
 
+        template<class Tparticle>
+            double electrostatic(const FunctorPotential<Tparticle> &pot, const Tparticle &a, const Tparticle &b, const Point &r) {
+                return pot.electrostatic(a, b, r);
+            }
+
 #ifdef DOCTEST_LIBRARY_INCLUDED
         TEST_CASE("[Faunus] FunctorPotential")
         {
@@ -959,6 +1090,10 @@ namespace Faunus {
             CHECK( u(a,a,r) == Approx( coulomb(a,a,r) ) );
             CHECK( u(b,b,r) == Approx( coulomb(b,b,r) ) );
             CHECK( u(a,b,r) == Approx( coulomb(a,b,r) + wca(a,b,r) ) );
+            CHECK( u.evaluate(b,a,r) == Approx( coulomb(a,b,r) + wca(a,b,r) ) );
+            CHECK( electrostatic(u,a,b,r) == Approx( coulomb(a,b,r) ) );
+            CHECK( electrostatic(coulomb,a,b,r) == Approx( coulomb(a,b,r) ) );
+            CHECK( electrostatic(wca,a,b,r) == 0 );
             CHECK( u(c,c,r*1.01) == 0 );
             CHECK( u(c,c,r*0.99) == pc::infty );
         }
@@ -1142,6 +1277,14 @@ namespace Faunus {
                 CHECK_THROWS( b = R"({"harmonic": { "index":[2], "k":0.5, "req":2.1}} )"_json );
                 CHECK_THROWS( b = R"({"harmonic": { "index":[2,3], "req":2.1}} )"_json );
                 CHECK_THROWS( b = R"({"harmonic": { "index":[2,3], "k":2.1}} )"_json );
+                CHECK( b->exclude == false );
+
+                // exclusion of non-bonded interactions
+                j = R"({ "harmonic": {"index":[2,3], "k":0.5, "req":2.1, "exclude":true, "keepelectrostatics":false}} )"_json;
+                b = j;
+                CHECK( b->exclude == true );
+                CHECK( b->keepelectrostatics == false );
+                CHECK( j == json(b) );
             }
 
             // test fene
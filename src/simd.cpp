@@ -0,0 +1,295 @@
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define FAU_SIMD_X86
+#include <immintrin.h>
+#if !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized" // false positive from `_mm*_undefined_pd()` in gcc intrinsics
+#endif
+#endif
+
+namespace Faunus {
+    namespace SIMD {
+
+        namespace {
+            constexpr double infty = std::numeric_limits<double>::infinity();
+            constexpr double twototwosixth = 1.2599210498948732; // 2^(1/3) = (2^(1/6))^2
+
+            ISA& current() {
+                static ISA isa = detect();
+                return isa;
+            }
+
+            /*
+             * Index of the splitting function spline interval containing q.
+             * For `Andrea` tables this follows `Tabulate::Andrea::eval()` but
+             * is clamped to valid intervals.
+             */
+            inline int knotIndex(const PairKernel &k, double q) {
+                auto &knots = k.spline.r2;
+                if (k.spline.uniform())
+                    return Tabulate::Uniform<double>::index(k.spline, q);
+                int pos = int(std::lower_bound(knots.begin(), knots.end(), q) - knots.begin()) - 1;
+                return std::max(0, std::min(pos, int(knots.size())-2));
+            }
+
+            inline double splitting(const PairKernel &k, double q) {
+                int pos = knotIndex(k, q);
+                const double *c = k.spline.c.data() + 6*pos;
+                double dz = q - k.spline.r2[pos];
+                return c[0] + dz * (c[1] + dz * (c[2] + dz * (c[3] + dz * (c[4] + dz * c[5]))));
+            }
+
+            /*
+             * Scalar pair energy; also used for the remainder of the vector loops
+             */
+            inline double pairEnergy(const PairKernel &k, double dx, double dy, double dz, double qq, int ij) {
+                dx -= k.box[0] * std::nearbyint(dx * k.boxinv[0]);
+                dy -= k.box[1] * std::nearbyint(dy * k.boxinv[1]);
+                dz -= k.box[2] * std::nearbyint(dz * k.boxinv[2]);
+                double r2 = dx*dx + dy*dy + dz*dz;
+                double u = 0;
+                if (k.coulomb != PairKernel::NOCHARGE && r2 < k.rc2) {
+                    double r = std::sqrt(r2);
+                    u = k.lB * qq / r;
+                    if (k.coulomb == PairKernel::SPLINE)
+                        u *= splitting(k, r * k.rc1i);
+                }
+                switch (k.shortranged) {
+                    case PairKernel::LJ:
+                    case PairKernel::WCA:
+                        {
+                            double s2 = k.s2[ij];
+                            if (k.shortranged == PairKernel::WCA && r2 > s2 * twototwosixth)
+                                break;
+                            double x = s2 / r2;
+                            x = x*x*x;
+                            u += k.eps[ij] * (k.shortranged == PairKernel::WCA ? x*x - x + 0.25 : x*x - x);
+                        }
+                        break;
+                    case PairKernel::HARDSPHERE:
+                        if (r2 < k.s2[ij])
+                            return infty;
+                        break;
+                    case PairKernel::NONE:
+                        break;
+                }
+                return u;
+            }
+        } // end of anonymous namespace
+
+        void PairKernel::setBox(double x, double y, double z, bool pbc) {
+            box[0] = x;
+            box[1] = y;
+            box[2] = z;
+            for (int i=0; i<3; i++)
+                boxinv[i] = pbc ? 1/box[i] : 0;
+        }
+
+        double oneToManyScalar(const PairKernel &k, double x, double y, double z, double charge, int id,
+                const Arrays &a, int first, int last) {
+            double u = 0;
+            int offset = id * k.ntypes;
+            for (int j=first; j<last; j++)
+                u += pairEnergy(k, a.x[j]-x, a.y[j]-y, a.z[j]-z, charge*a.charge[j], offset + a.id[j]);
+            return u;
+        }
+
+#ifdef FAU_SIMD_X86
+        __attribute__((target("avx2,fma")))
+        double oneToManyAVX2(const PairKernel &k, double x, double y, double z, double charge, int id,
+                const Arrays &a, int first, int last) {
+            constexpr int round = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+            const __m256d xi = _mm256_set1_pd(x), yi = _mm256_set1_pd(y), zi = _mm256_set1_pd(z);
+            const __m256d Lx = _mm256_set1_pd(k.box[0]), Ly = _mm256_set1_pd(k.box[1]), Lz = _mm256_set1_pd(k.box[2]);
+            const __m256d Lxi = _mm256_set1_pd(k.boxinv[0]), Lyi = _mm256_set1_pd(k.boxinv[1]), Lzi = _mm256_set1_pd(k.boxinv[2]);
+            const __m256d lBqi = _mm256_set1_pd(k.lB * charge), rc2 = _mm256_set1_pd(k.rc2), rc1i = _mm256_set1_pd(k.rc1i);
+            const __m256d quarter = _mm256_set1_pd(0.25), wca = _mm256_set1_pd(twototwosixth);
+            const __m128i offset = _mm_set1_epi32(id * k.ntypes);
+            __m256d sum = _mm256_setzero_pd();
+
+            int j = first;
+            for (; j + 4 <= last; j += 4) {
+                __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(a.x + j), xi);
+                __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(a.y + j), yi);
+                __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(a.z + j), zi);
+                dx = _mm256_fnmadd_pd(Lx, _mm256_round_pd(_mm256_mul_pd(dx, Lxi), round), dx);
+                dy = _mm256_fnmadd_pd(Ly, _mm256_round_pd(_mm256_mul_pd(dy, Lyi), round), dy);
+                dz = _mm256_fnmadd_pd(Lz, _mm256_round_pd(_mm256_mul_pd(dz, Lzi), round), dz);
+                __m256d r2 = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dz, dz)));
+                __m256d u = _mm256_setzero_pd();
+
+                if (k.coulomb != PairKernel::NOCHARGE) {
+                    __m256d mask = _mm256_cmp_pd(r2, rc2, _CMP_LT_OQ);
+                    int bits = _mm256_movemask_pd(mask);
+                    if (bits) {
+                        __m256d r = _mm256_sqrt_pd(r2);
+                        u = _mm256_div_pd(_mm256_mul_pd(lBqi, _mm256_loadu_pd(a.charge + j)), r);
+                        if (k.coulomb == PairKernel::SPLINE) {
+                            alignas(32) double q[4];
+                            alignas(16) int pos[4];
+                            __m256d qv = _mm256_mul_pd(r, rc1i);
+                            _mm256_store_pd(q, qv);
+                            for (int l=0; l<4; l++)
+                                pos[l] = (bits & (1<<l)) ? knotIndex(k, q[l]) : 0;
+                            __m128i p = _mm_load_si128(reinterpret_cast<const __m128i*>(pos));
+                            __m128i p6 = _mm_mullo_epi32(p, _mm_set1_epi32(6));
+                            const double *c = k.spline.c.data();
+                            __m256d dq = _mm256_sub_pd(qv, _mm256_i32gather_pd(k.spline.r2.data(), p, 8));
+                            __m256d s = _mm256_i32gather_pd(c + 5, p6, 8);
+                            s = _mm256_fmadd_pd(s, dq, _mm256_i32gather_pd(c + 4, p6, 8));
+                            s = _mm256_fmadd_pd(s, dq, _mm256_i32gather_pd(c + 3, p6, 8));
+                            s = _mm256_fmadd_pd(s, dq, _mm256_i32gather_pd(c + 2, p6, 8));
+                            s = _mm256_fmadd_pd(s, dq, _mm256_i32gather_pd(c + 1, p6, 8));
+                            s = _mm256_fmadd_pd(s, dq, _mm256_i32gather_pd(c, p6, 8));
+                            u = _mm256_mul_pd(u, s);
+                        }
+                        u = _mm256_and_pd(mask, u);
+                    }
+                }
+
+                if (k.shortranged != PairKernel::NONE) {
+                    __m128i ij = _mm_add_epi32(offset, _mm_loadu_si128(reinterpret_cast<const __m128i*>(a.id + j)));
+                    __m256d s2 = _mm256_i32gather_pd(k.s2.data(), ij, 8);
+                    if (k.shortranged == PairKernel::HARDSPHERE) {
+                        if (_mm256_movemask_pd(_mm256_cmp_pd(r2, s2, _CMP_LT_OQ)))
+                            return infty;
+                    } else {
+                        __m256d eps = _mm256_i32gather_pd(k.eps.data(), ij, 8);
+                        __m256d x6 = _mm256_div_pd(s2, r2);
+                        x6 = _mm256_mul_pd(x6, _mm256_mul_pd(x6, x6));
+                        __m256d v = _mm256_fmsub_pd(x6, x6, x6);
+                        if (k.shortranged == PairKernel::WCA) {
+                            v = _mm256_add_pd(v, quarter);
+                            v = _mm256_and_pd(_mm256_cmp_pd(r2, _mm256_mul_pd(s2, wca), _CMP_LE_OQ), v);
+                        }
+                        u = _mm256_fmadd_pd(eps, v, u);
+                    }
+                }
+                sum = _mm256_add_pd(sum, u);
+            }
+
+            alignas(32) double lanes[4];
+            _mm256_store_pd(lanes, sum);
+            return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + oneToManyScalar(k, x, y, z, charge, id, a, j, last);
+        }
+
+        __attribute__((target("avx512f")))
+        double oneToManyAVX512(const PairKernel &k, double x, double y, double z, double charge, int id,
+                const Arrays &a, int first, int last) {
+            constexpr int round = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+            const __m512d xi = _mm512_set1_pd(x), yi = _mm512_set1_pd(y), zi = _mm512_set1_pd(z);
+            const __m512d Lx = _mm512_set1_pd(k.box[0]), Ly = _mm512_set1_pd(k.box[1]), Lz = _mm512_set1_pd(k.box[2]);
+            const __m512d Lxi = _mm512_set1_pd(k.boxinv[0]), Lyi = _mm512_set1_pd(k.boxinv[1]), Lzi = _mm512_set1_pd(k.boxinv[2]);
+            const __m512d lBqi = _mm512_set1_pd(k.lB * charge), rc2 = _mm512_set1_pd(k.rc2), rc1i = _mm512_set1_pd(k.rc1i);
+            const __m512d quarter = _mm512_set1_pd(0.25), wca = _mm512_set1_pd(twototwosixth);
+            const __m256i offset = _mm256_set1_epi32(id * k.ntypes);
+            __m512d sum = _mm512_setzero_pd();
+
+            int j = first;
+            for (; j + 8 <= last; j += 8) {
+                __m512d dx = _mm512_sub_pd(_mm512_loadu_pd(a.x + j), xi);
+                __m512d dy = _mm512_sub_pd(_mm512_loadu_pd(a.y + j), yi);
+                __m512d dz = _mm512_sub_pd(_mm512_loadu_pd(a.z + j), zi);
+                dx = _mm512_fnmadd_pd(Lx, _mm512_roundscale_pd(_mm512_mul_pd(dx, Lxi), round), dx);
+                dy = _mm512_fnmadd_pd(Ly, _mm512_roundscale_pd(_mm512_mul_pd(dy, Lyi), round), dy);
+                dz = _mm512_fnmadd_pd(Lz, _mm512_roundscale_pd(_mm512_mul_pd(dz, Lzi), round), dz);
+                __m512d r2 = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dz, dz)));
+                __m512d u = _mm512_setzero_pd();
+
+                if (k.coulomb != PairKernel::NOCHARGE) {
+                    __mmask8 mask = _mm512_cmp_pd_mask(r2, rc2, _CMP_LT_OQ);
+                    if (mask) {
+                        __m512d r = _mm512_sqrt_pd(r2);
+                        __m512d v = _mm512_div_pd(_mm512_mul_pd(lBqi, _mm512_loadu_pd(a.charge + j)), r);
+                        if (k.coulomb == PairKernel::SPLINE) {
+                            alignas(64) double q[8];
+                            alignas(32) int pos[8];
+                            __m512d qv = _mm512_mul_pd(r, rc1i);
+                            _mm512_store_pd(q, qv);
+                            for (int l=0; l<8; l++)
+                                pos[l] = (mask & (1<<l)) ? knotIndex(k, q[l]) : 0;
+                            __m256i p = _mm256_load_si256(reinterpret_cast<const __m256i*>(pos));
+                            __m256i p6 = _mm256_add_epi32(_mm256_add_epi32(p, p), _mm256_slli_epi32(p, 2));
+                            const double *c = k.spline.c.data();
+                            __m512d dq = _mm512_sub_pd(qv, _mm512_i32gather_pd(p, k.spline.r2.data(), 8));
+                            __m512d s = _mm512_i32gather_pd(p6, c + 5, 8);
+                            s = _mm512_fmadd_pd(s, dq, _mm512_i32gather_pd(p6, c + 4, 8));
+                            s = _mm512_fmadd_pd(s, dq, _mm512_i32gather_pd(p6, c + 3, 8));
+                            s = _mm512_fmadd_pd(s, dq, _mm512_i32gather_pd(p6, c + 2, 8));
+                            s = _mm512_fmadd_pd(s, dq, _mm512_i32gather_pd(p6, c + 1, 8));
+                            s = _mm512_fmadd_pd(s, dq, _mm512_i32gather_pd(p6, c, 8));
+                            v = _mm512_mul_pd(v, s);
+                        }
+                        u = _mm512_maskz_mov_pd(mask, v);
+                    }
+                }
+
+                if (k.shortranged != PairKernel::NONE) {
+                    __m256i ij = _mm256_add_epi32(offset, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a.id + j)));
+                    __m512d s2 = _mm512_i32gather_pd(ij, k.s2.data(), 8);
+                    if (k.shortranged == PairKernel::HARDSPHERE) {
+                        if (_mm512_cmp_pd_mask(r2, s2, _CMP_LT_OQ))
+                            return infty;
+                    } else {
+                        __m512d eps = _mm512_i32gather_pd(ij, k.eps.data(), 8);
+                        __m512d x6 = _mm512_div_pd(s2, r2);
+                        x6 = _mm512_mul_pd(x6, _mm512_mul_pd(x6, x6));
+                        __m512d v = _mm512_fmsub_pd(x6, x6, x6);
+                        if (k.shortranged == PairKernel::WCA)
+                            v = _mm512_maskz_add_pd(_mm512_cmp_pd_mask(r2, _mm512_mul_pd(s2, wca), _CMP_LE_OQ), v, quarter);
+                        u = _mm512_fmadd_pd(eps, v, u);
+                    }
+                }
+                sum = _mm512_add_pd(sum, u);
+            }
+            return _mm512_reduce_add_pd(sum) + oneToManyScalar(k, x, y, z, charge, id, a, j, last);
+        }
+
+        ISA detect() {
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f"))
+                return ISA::AVX512;
+            if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+                return ISA::AVX2;
+            return ISA::SCALAR;
+        }
+#else
+        double oneToManyAVX2(const PairKernel &k, double x, double y, double z, double charge, int id,
+                const Arrays &a, int first, int last) {
+            return oneToManyScalar(k, x, y, z, charge, id, a, first, last);
+        }
+
+        double oneToManyAVX512(const PairKernel &k, double x, double y, double z, double charge, int id,
+                const Arrays &a, int first, int last) {
+            return oneToManyScalar(k, x, y, z, charge, id, a, first, last);
+        }
+
+        ISA detect() { return ISA::SCALAR; }
+#endif
+
+        ISA instructionSet() { return current(); }
+
+        void setInstructionSet(ISA isa) { current() = std::min(isa, detect()); }
+
+        std::string to_string(ISA isa) {
+            switch (isa) {
+                case ISA::AVX512: return "avx512";
+                case ISA::AVX2: return "avx2";
+                default: return "scalar";
+            }
+        }
+
+        double oneToMany(const PairKernel &k, double x, double y, double z, double charge, int id,
+                const Arrays &a, int first, int last) {
+            switch (current()) {
+                case ISA::AVX512: return oneToManyAVX512(k, x, y, z, charge, id, a, first, last);
+                case ISA::AVX2: return oneToManyAVX2(k, x, y, z, charge, id, a, first, last);
+                default: return oneToManyScalar(k, x, y, z, charge, id, a, first, last);
+            }
+        }
+
+    }//namespace
+}//namespace
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <limits>
+#include <cmath>
+#include "tabulate.h"
+
+namespace Faunus {
+
+    /**
+     * @brief Explicitly vectorized pair energy kernels
+     *
+     * The kernels sum the interaction energy of one particle with a
+     * contiguous range of particles stored as a structure of arrays
+     * (see `ParticleMirror`). Distances use the minimum image convention
+     * for orthorhombic boxes and the energy is a sum of an electrostatic
+     * term (`PLAIN` or `SPLINE`) and a short ranged term (`LJ`, `WCA`, or
+     * `HARDSPHERE`), each of which can be disabled.
+     * `PLAIN` is @f$ l_B q_iq_j/r @f$ inside the cutoff while `SPLINE`
+     * multiplies this by a splitting function, @f$S(r/R_c)@f$, tabulated
+     * by `Tabulate::Andrea` or `Tabulate::Uniform`; the polynomial is
+     * evaluated in vector lanes after a per-lane interval lookup which is
+     * constant time for uniform tables. Pair parameters are looked up in
+     * flattened `ntypes x ntypes` tables.
+     *
+     * Three implementations are available and the fastest one supported
+     * by the CPU is selected at runtime, allowing a single binary to run
+     * on hardware with and without AVX2/AVX-512:
+     *
+     * - `SCALAR`: plain C++, always available
+     * - `AVX2`: four doubles per register (requires AVX2 and FMA)
+     * - `AVX512`: eight doubles per register (requires AVX-512F)
+     *
+     * The vector kernels use a different summation order (and FMA) than
+     * the scalar loop so energies agree to a relative tolerance of
+     * `SIMD::tolerance` rather than bitwise.
+     */
+    namespace SIMD {
+
+        enum class ISA {SCALAR=0, AVX2, AVX512}; //!< Instruction set architectures
+
+        constexpr double tolerance = 1e-10; //!< Max. relative deviation between kernels
+
+        ISA detect();                     //!< Best instruction set supported by CPU and binary
+        ISA instructionSet();             //!< Currently used instruction set
+        void setInstructionSet(ISA isa);  //!< Select instruction set (capped by `detect()`)
+        std::string to_string(ISA isa);   //!< Name of instruction set
+
+        /**
+         * @brief Parameters for the one-to-many energy kernels
+         */
+        struct PairKernel {
+            enum Electrostatics {NOCHARGE=0, PLAIN, SPLINE};
+            enum ShortRanged {NONE=0, LJ, WCA, HARDSPHERE};
+
+            Electrostatics coulomb = NOCHARGE;
+            ShortRanged shortranged = NONE;
+
+            double box[3] = {1,1,1};    //!< Side lengths for minimum image
+            double boxinv[3] = {0,0,0}; //!< Inverse side lengths (zero disables PBC)
+
+            double lB = 0;              //!< Bjerrum length
+            double rc2 = std::numeric_limits<double>::infinity(); //!< Squared electrostatic cutoff
+            double rc1i = 0;            //!< Inverse electrostatic cutoff
+            Tabulate::TabulatorBase<double>::data spline; //!< Splitting function in q=r/Rc
+
+            int ntypes = 0;             //!< Number of atom types
+            std::vector<double> s2;     //!< sigma^2 (LJ, WCA) or contact distance^2 (hard sphere)
+            std::vector<double> eps;    //!< 4 x epsilon (LJ, WCA)
+
+            void setBox(double x, double y, double z, bool pbc=true); //!< Set box lengths for minimum image
+        };
+
+        /**
+         * @brief Pointers to structure of arrays particle data
+         */
+        struct Arrays {
+            const double *x, *y, *z, *charge;
+            const int *id;
+        };
+
+        /**
+         * @brief Energy of a particle at (x,y,z) with particles [first:last[
+         * @param k Kernel parameters
+         * @param x Position of particle
+         * @param y Position of particle
+         * @param z Position of particle
+         * @param charge Charge of particle
+         * @param id Atom type of particle
+         * @param a Particle arrays to interact with
+         * @param first Index of first particle in `a`
+         * @param last Index of one past last particle in `a`
+         *
+         * The range must not contain the particle itself.
+         */
+        double oneToMany(const PairKernel &k, double x, double y, double z, double charge, int id,
+                const Arrays &a, int first, int last);
+
+        double oneToManyScalar(const PairKernel&, double, double, double, double, int, const Arrays&, int, int);
+        double oneToManyAVX2(const PairKernel&, double, double, double, double, int, const Arrays&, int, int);
+        double oneToManyAVX512(const PairKernel&, double, double, double, double, int, const Arrays&, int, int);
+
+#ifdef DOCTEST_LIBRARY_INCLUDED
+        TEST_CASE("[Faunus] SIMD::oneToMany")
+        {
+            int n=101;
+            std::vector<double> x(n), y(n), z(n), q(n);
+            std::vector<int> id(n);
+            for (int i=0; i<n; i++) {
+                x[i] = std::fmod(7.3*i, 20.0) - 10; // deterministic scatter in [-10:10[
+                y[i] = std::fmod(3.1*i*i, 20.0) - 10;
+                z[i] = std::fmod(11.7*i, 20.0) - 10;
+                q[i] = (i%2==0) ? 1 : -1;
+                id[i] = i%2;
+            }
+            Arrays a = {x.data(), y.data(), z.data(), q.data(), id.data()};
+            PairKernel k;
+            k.setBox(20, 20, 20);
+            k.coulomb = PairKernel::PLAIN;
+            k.lB = 7;
+            k.shortranged = PairKernel::LJ;
+            k.ntypes = 2;
+            k.s2 = {1, 2.25, 2.25, 4};
+            k.eps = {0.4, 0.8, 0.8, 1.2};
+
+            double u=0; // reference using direct pair sum
+            for (int j=1; j<n; j++) {
+                double d[3] = {x[j]-x[0], y[j]-y[0], z[j]-z[0]};
+                for (auto &di : d)
+                    di -= 20*std::round(di/20);
+                double r2 = d[0]*d[0] + d[1]*d[1] + d[2]*d[2];
+                double s6 = std::pow(k.s2[id[j]]/r2, 3);
+                u += k.lB*q[0]*q[j]/std::sqrt(r2) + k.eps[id[j]]*(s6*s6-s6);
+            }
+            CHECK( oneToManyScalar(k, x[0], y[0], z[0], q[0], id[0], a, 1, n) == doctest::Approx(u).epsilon(tolerance) );
+
+            auto isa = instructionSet();
+            for (auto i : {ISA::SCALAR, ISA::AVX2, ISA::AVX512}) {
+                setInstructionSet(i);
+                CHECK( instructionSet() <= detect() );
+                CHECK( oneToMany(k, x[0], y[0], z[0], q[0], id[0], a, 1, n) == doctest::Approx(u).epsilon(tolerance) );
+                CHECK( oneToMany(k, x[0], y[0], z[0], q[0], id[0], a, 1, 1) == 0 );
+
+                k.shortranged = PairKernel::HARDSPHERE;
+                k.s2 = {1e4, 1e4, 1e4, 1e4}; // everything overlaps
+                CHECK( oneToMany(k, x[0], y[0], z[0], q[0], id[0], a, 1, n) == std::numeric_limits<double>::infinity() );
+                k.shortranged = PairKernel::LJ;
+                k.s2 = {1, 2.25, 2.25, 4};
+            }
+            setInstructionSet(isa);
+        }
+#endif
+    }//namespace
+}//namespace
@@ -1,5 +1,6 @@
 #pragma once
 #include "core.h"
+#include "auxiliary.h"
 #include "geometry.h"
 #include "group.h"
 #include "molecule.h"
@@ -133,6 +134,55 @@ namespace Faunus {
             getActiveParticles(const Tspace &spc) : spc(spc) {};
         };
 
+    /**
+     * @brief Structure-of-arrays mirror of particle positions, charges and types
+     *
+     * Arrays are aligned and padded to a multiple of `padding` elements so that
+     * vector instructions can load full registers without tail handling.
+     * Padded elements are zero. The mirror is disabled by default and is then
+     * never touched; energy terms that want contiguous arrays call `enable()`
+     * whereafter `Space` keeps it up to date.
+     */
+    struct ParticleMirror {
+        template<class T> using Tvec = std::vector<T, AlignedAllocator<T,64>>;
+        static constexpr size_t padding = 8; //!< Elements per AVX-512 register (double)
+        Tvec<double> x, y, z, charge;
+        Tvec<int> id;
+        size_t n=0; //!< Number of (unpadded) particles
+        bool enabled=false;
+
+        template<class Tparticle>
+            void set(size_t i, const Tparticle &a) {
+                x[i] = a.pos.x();
+                y[i] = a.pos.y();
+                z[i] = a.pos.z();
+                charge[i] = a.charge;
+                id[i] = a.id;
+            } //!< Copy particle data into element `i`
+
+        template<class Tpvec>
+            void update(const Tpvec &p, size_t first, size_t last) {
+                for (size_t i=first; i<last; i++)
+                    set(i, p[i]);
+            } //!< Update element range [first:last[
+
+        template<class Tpvec>
+            void update(const Tpvec &p) {
+                n = p.size();
+                size_t size = (n + padding - 1) / padding * padding;
+                for (auto v : {&x, &y, &z, &charge})
+                    v->assign(size, 0.0);
+                id.assign(size, 0);
+                update(p, 0, n);
+            } //!< Resize and update all elements
+
+        template<class Tpvec>
+            void enable(const Tpvec &p) {
+                enabled = true;
+                update(p);
+            } //!< Enable mirror and copy all particles
+    };
+
     template<class Tgeometry, class Tparticletype>
         struct Space {
 
@@ -148,12 +198,285 @@ namespace Faunus {
             typedef std::function<void(Tspace&, const Tspace&, const Tchange&)> SyncTrigger;
 
             std::vector<ScaleVolumeTrigger> scaleVolumeTriggers; //!< Call when volume is scaled
-            std::vector<ChangeTrigger> changeTriggers; //!< Call when a Change object is applied
+            std::vector<ChangeTrigger> changeTriggers; //!< Call when a Change object is applied or undone
             std::vector<SyncTrigger> onSyncTriggers;   //!< Call when two Space objects are synched
 
             Tpvec p;       //!< Particle vector
             Tgvec groups;  //!< Group vector
             Tgeometry geo; //!< Container geometry
+            ParticleMirror mirror; //!< Optional structure-of-arrays copy of `p`
+
+            /**
+             * @brief Data overwritten by a move, allowing the move to be undone
+             *
+             * Used by single-state simulations where trial moves modify the only
+             * `Space`. Moves call `backup()` or `backupAll()` before modifying
+             * particles, groups or the geometry; nothing is recorded unless
+             * `enabled` is set.
+             */
+            struct UndoLog {
+                bool enabled=false; //!< Record backups
+                bool dV=false;      //!< True if `geo` holds a backup of the geometry
+                Tgeometry geo;      //!< Geometry backup
+                std::vector<std::pair<size_t,Tparticle>> particles; //!< Index in `p` and particle backup
+                std::vector<std::pair<size_t,Tgroup>> groups;       //!< Index in `groups` and group data backup
+                std::vector<bool> loggedParticles, loggedGroups;     //!< Lookup of already recorded indices
+
+                bool empty() const { return particles.empty() and groups.empty() and not dV; }
+            };
+            UndoLog undolog; //!< Undo log for single-state simulations (see `backup()`, `undo()`)
+
+            /**
+             * @brief Group indices for each molecule type
+             *
+             * Sorted lists of indices in `groups` for all, fully active
+             * (`size()==capacity()`) and inactive groups of each molecule id.
+             * Used by `findMolecules()` and `randomMolecule()` so that these
+             * need not scan all groups.
+             */
+            struct MoleculeIndex {
+                std::vector<std::vector<int>> all, active, inactive; //!< Group indices, accessed by molid
+                size_t ngroups=0; //!< Number of indexed groups
+            };
+            MoleculeIndex molindex;
+
+            /**
+             * @brief Particle lookup tables
+             *
+             * For each particle in `p`, the index of the group it belongs to
+             * (whether active or not), and for each atom type an unordered list
+             * of active particle indices. Used by `findGroupContaining()`,
+             * `findAtoms()` and `activeParticles()` so that these need not scan
+             * all groups.
+             */
+            struct ParticleIndex {
+                std::vector<int> group;    //!< Group index of each particle
+                std::vector<int> type;     //!< Atom id under which each particle is listed; -1 if inactive
+                std::vector<int> position; //!< Position of each particle in its `active` list
+                std::vector<std::vector<int>> active; //!< Active particle indices, accessed by atom id
+            };
+            ParticleIndex particleindex;
+
+            /*
+             * Both indices are kept current by `push_back()`, `clear()`, and by
+             * `update()`, `sync()` and `undo()` for the groups and particles in
+             * the change object. Groups or particles that are activated,
+             * deactivated or change atom type elsewhere must be reported with
+             * `reindex()` or `reindexParticle()`.
+             */
+
+            bool indexed() const {
+                return molindex.ngroups==groups.size() and particleindex.group.size()==p.size();
+            } //!< True if indices cover all groups and particles
+
+            void indexParticle(size_t i) {
+                auto &x = particleindex;
+                int gindex = x.group[i];
+                int id = (gindex>=0 and groups[gindex].contains(p[i])) ? p[i].id : -1;
+                if (id!=x.type[i]) {
+                    if (x.type[i]>=0) { // remove by moving last element into its place
+                        auto &l = x.active[x.type[i]];
+                        l[x.position[i]] = l.back();
+                        x.position[l.back()] = x.position[i];
+                        l.pop_back();
+                    }
+                    if (id>=0) {
+                        if (size_t(id)>=x.active.size())
+                            x.active.resize(id+1);
+                        x.position[i] = x.active[id].size();
+                        x.active[id].push_back(i);
+                    }
+                    x.type[i] = id;
+                }
+            } //!< Update atom type lists for particle `i`
+
+            void indexMolecule(int i) {
+                auto &g = groups.at(i);
+                if (g.id>=0) {
+                    bool active = (g.size()==g.capacity());
+                    auto &from = (active ? molindex.inactive : molindex.active)[g.id];
+                    auto it = std::lower_bound(from.begin(), from.end(), i);
+                    if (it!=from.end() && *it==i) {
+                        from.erase(it);
+                        auto &to = (active ? molindex.active : molindex.inactive)[g.id];
+                        to.insert( std::lower_bound(to.begin(), to.end(), i), i );
+                    }
+                }
+            } //!< Move group `i` between active and inactive molecule lists if needed
+
+            void indexGroup(size_t i) {
+                auto &m = molindex;
+                auto &g = groups[i];
+                if (g.id>=0) {
+                    if (size_t(g.id)>=m.all.size())
+                        for (auto v : {&m.all, &m.active, &m.inactive})
+                            v->resize(g.id+1);
+                    m.all[g.id].push_back(i);
+                    (g.size()==g.capacity() ? m.active : m.inactive)[g.id].push_back(i);
+                }
+                m.ngroups = i+1;
+
+                auto &x = particleindex;
+                if (x.group.size()!=p.size()) {
+                    x.group.resize(p.size(), -1);
+                    x.type.resize(p.size(), -1);
+                    x.position.resize(p.size(), -1);
+                }
+                size_t first = std::distance(p.begin(), g.begin());
+                for (size_t j=first; j<first+g.capacity(); j++) {
+                    x.group[j] = i;
+                    indexParticle(j);
+                }
+            } //!< Append group `i` and its particles to indices (all groups before `i` must be indexed)
+
+            void reindex() {
+                for (auto v : {&molindex.all, &molindex.active, &molindex.inactive}) {
+                    if (v->size() < molecules<Tpvec>.size())
+                        v->resize(molecules<Tpvec>.size());
+                    for (auto &i : *v)
+                        i.clear(); // keep (empty) lists as views may refer to them
+                }
+                auto &x = particleindex;
+                if (x.active.size() < atoms.size())
+                    x.active.resize(atoms.size());
+                for (auto &i : x.active)
+                    i.clear();
+                x.group.assign(p.size(), -1);
+                x.type.assign(p.size(), -1);
+                x.position.assign(p.size(), -1);
+                molindex.ngroups=0;
+                for (size_t i=0; i<groups.size(); i++)
+                    indexGroup(i);
+            } //!< Rebuild all indices (complexity: order N)
+
+            void reindexParticle(size_t i) {
+                if (not indexed())
+                    return reindex();
+                indexParticle(i);
+            } //!< Update indices after activation, deactivation or type change of particle `i`
+
+            void reindex(int i) {
+                if (not indexed())
+                    return reindex();
+                indexMolecule(i);
+                size_t first = std::distance(p.begin(), groups[i].begin());
+                for (size_t j=first; j<first+groups[i].capacity(); j++)
+                    indexParticle(j);
+            } //!< Update indices after activation or deactivation of group `i` (complexity: group capacity)
+
+            void reindex(const typename Tchange::data &d) {
+                if (d.all or d.atoms.empty())
+                    return reindex(d.index);
+                if (not indexed())
+                    return reindex();
+                indexMolecule(d.index);
+                size_t first = std::distance(p.begin(), groups[d.index].begin());
+                for (int j : d.atoms)
+                    indexParticle(first+j);
+            } //!< Update indices for group and particles described by `d`
+
+            void backup(int gindex, int atom=-1) {
+                auto &log = undolog;
+                if (log.enabled) {
+                    auto &g = groups.at(gindex);
+                    if (log.loggedGroups.size()!=groups.size())
+                        log.loggedGroups.resize(groups.size(), false);
+                    if (log.loggedParticles.size()!=p.size())
+                        log.loggedParticles.resize(p.size(), false);
+                    if (not log.loggedGroups[gindex]) {
+                        log.loggedGroups[gindex] = true;
+                        log.groups.emplace_back(gindex, g);
+                    }
+                    size_t first = std::distance(p.begin(), g.begin());
+                    size_t last = (atom<0) ? first+g.capacity() : first+atom+1;
+                    for (size_t i = (atom<0) ? first : first+atom; i<last; i++)
+                        if (not log.loggedParticles[i]) {
+                            log.loggedParticles[i] = true;
+                            log.particles.emplace_back(i, p[i]);
+                        }
+                }
+            } //!< Record group `gindex` and all its particles or only `atom` (relative to group) before modification
+
+            void backupAll() {
+                if (undolog.enabled) {
+                    for (size_t i=0; i<groups.size(); i++)
+                        backup(i);
+                    if (not undolog.dV) {
+                        undolog.geo = geo;
+                        undolog.dV = true;
+                    }
+                }
+            } //!< Record geometry and all groups and particles before modification
+
+            void undo(const Tchange &change) {
+                for (auto &i : undolog.particles)
+                    std::swap(p[i.first], i.second);
+                for (auto &i : undolog.groups) {
+                    Tgroup current( groups[i.first] ); // group data only; particles are shared
+                    groups[i.first].shallowcopy(i.second);
+                    i.second.shallowcopy(current);
+                }
+                if (undolog.dV)
+                    std::swap(geo, undolog.geo);
+                if (indexed()) {
+                    for (auto &i : undolog.groups)
+                        indexMolecule(i.first);
+                    for (auto &i : undolog.particles)
+                        indexParticle(i.first);
+                }
+                updateMirror(change);
+                for (auto &f : changeTriggers)
+                    f(*this, change);
+            } //!< Swap current and recorded data; calling twice re-applies the change
+
+            void commit() {
+                for (auto &i : undolog.particles)
+                    undolog.loggedParticles[i.first] = false;
+                for (auto &i : undolog.groups)
+                    undolog.loggedGroups[i.first] = false;
+                undolog.particles.clear();
+                undolog.groups.clear();
+                undolog.dV = false;
+            } //!< Discard undo log, making the current state permanent
+
+            void updateMirror(const Tchange &change) {
+                if (mirror.enabled) {
+                    if (change.all || change.dV || mirror.n!=p.size())
+                        mirror.update(p);
+                    else
+                        for (auto &d : change.groups) {
+                            auto &g = groups.at(d.index);
+                            size_t offset = std::distance(p.begin(), g.begin());
+                            if (d.all || d.atoms.empty() || change.dN)
+                                mirror.update(p, offset, offset+g.capacity());
+                            else
+                                for (int i : d.atoms)
+                                    mirror.set(offset+i, p[offset+i]);
+                        }
+                }
+            } //!< Update structure-of-arrays mirror (if enabled) for particles touched by `change`
+
+            void updateRadius(const Tchange &change) {
+                auto vdist = [&geo=geo](const Point &a, const Point &b) { return geo.vdist(a,b); };
+                if (change.all || change.dV)
+                    for (auto &g : groups)
+                        g.updateRadius(vdist);
+                else
+                    for (auto &d : change.groups)
+                        groups.at(d.index).updateRadius(vdist);
+            } //!< Update bounding radius of groups touched by `change`
+
+            void update(const Tchange &change) {
+                updateMirror(change);
+                updateRadius(change);
+                if (change.all)
+                    reindex();
+                else if (change.dN)
+                    for (auto &d : change.groups)
+                        reindex(d);
+                for (auto &f : changeTriggers)
+                    f(*this, change);
+            } //!< Call after particles have been modified as described by `change`
 
             auto positions() const {
                return ranges::view::transform(p, [](auto &i) -> const Point& {return i.pos;});
@@ -164,6 +487,7 @@ namespace Faunus {
             void clear() {
                 p.clear();
                 groups.clear();
+                reindex();
             } //!< Clears particle and molecule list
 
             /*
@@ -194,25 +518,33 @@ namespace Faunus {
                     }
 
                     groups.push_back(g);
+                    if (molindex.ngroups+1==groups.size())
+                        indexGroup(groups.size()-1);
+                    else
+                        reindex();
                     assert( in.size() == groups.back().capacity() );
                 }
             } //!< Safely add particles and corresponding group to back
 
             auto findMolecules(int molid, Selection sel=ACTIVE) {
-                std::function<bool(Tgroup&)> f;
-                switch (sel) {
-                    case (ALL):
-                        f = [molid](Tgroup &i){ return i.id==molid; };
-                        break;
-                    case (INACTIVE):
-                        f = [molid](Tgroup &i){ return (i.id==molid) && (i.size()!=i.capacity()); };
-                        break;
-                    case (ACTIVE):
-                        f = [molid](Tgroup &i){ return (i.id==molid) && (i.size()==i.capacity()); };
-                        break;
-                }
-                return groups | ranges::view::filter(f);
-            } //!< Range with all groups of type `molid` (complexity: order N)
+                if (not indexed())
+                    reindex();
+                static std::vector<int> none; // unknown molid
+                auto *index = &none;
+                if (molid>=0 and size_t(molid)<molindex.all.size())
+                    switch (sel) {
+                        case (ALL):
+                            index = &molindex.all[molid];
+                            break;
+                        case (INACTIVE):
+                            index = &molindex.inactive[molid];
+                            break;
+                        case (ACTIVE):
+                            index = &molindex.active[molid];
+                            break;
+                    }
+                return ranges::view::transform(*index, [&groups=groups](int i) -> Tgroup& { return groups[i]; });
+            } //!< Random access range with all groups of type `molid`, in group order (see `MoleculeIndex`)
 
             typename decltype(groups)::iterator randomMolecule(int molid, Random &rand, Selection sel=ACTIVE) {
                 auto m = findMolecules(molid, sel);
@@ -221,32 +553,44 @@ namespace Faunus {
                 return groups.end();
             } //!< Random group; groups.end() if not found
 
-            // auto findAtoms(int atomid) const {
-            //    return p | ranges::view::filter( [atomid](auto &i){ return i.id==atomid; } );
-            // } //!< Range with all atoms of type `atomid` (complexity: order N)
+            size_t numMolecules(int molid, Selection sel=ACTIVE) {
+                auto m = findMolecules(molid, sel);
+                return ranges::size(m);
+            } //!< Number of groups of type `molid` (complexity: constant)
 
             auto findAtoms(int atomid) {
-                auto f = [atomid,&groups=groups](Tparticle &i) {
-                    if (i.id==atomid) 
-                        for (auto &g : groups) 
-                            if (g.contains(i)) 
-                                return true;
-                    return false;
-                };
-                return ranges::view::filter(p, f);
-            } //!< Range with all atoms of type `atomid` (complexity: order N)
+                if (not indexed())
+                    reindex();
+                static std::vector<int> none; // unknown atom id
+                auto &x = particleindex;
+                auto &index = (atomid>=0 and size_t(atomid)<x.active.size()) ? x.active[atomid] : none;
+                return ranges::view::transform(index, [&p=p](int i) -> Tparticle& { return p[i]; });
+            } //!< Random access range with all active atoms of type `atomid`, in no particular order (see `ParticleIndex`)
+
+            size_t numAtoms(int atomid) {
+                auto m = findAtoms(atomid);
+                return ranges::size(m);
+            } //!< Number of active atoms of type `atomid` (complexity: constant)
 
             auto findGroupContaining(const Tparticle &i) {
-                return std::find_if( groups.begin(), groups.end(), [&i](auto &g){ return g.contains(i); });
-            } //!< Finds the groups containing the given atom
+                if (not indexed())
+                    reindex();
+                auto d = &i - p.data();
+                if (d>=0 and size_t(d)<p.size()) {
+                    int gindex = particleindex.group[d];
+                    if (gindex>=0 and groups[gindex].contains(i))
+                        return groups.begin()+gindex;
+                }
+                return groups.end();
+            } //!< Finds the group containing the given atom; `groups.end()` if not found or inactive
 
             auto activeParticles() {
-                auto f = [&groups=groups](Tparticle &i) {
-                    for (auto &g : groups)
-                        if (g.contains(i)) // true if particle is within active part
-                            return true;
-                    return false;
-                }; 
+                if (not indexed())
+                    reindex();
+                auto f = [this](Tparticle &i) {
+                    int gindex = particleindex.group[&i - p.data()];
+                    return (gindex>=0 and groups[gindex].contains(i)); // true if particle is within active part
+                };
                 return ranges::view::filter(p, f);
             } //!< Returns range with all *active* particles in space
 
@@ -268,6 +612,7 @@ namespace Faunus {
                         if (groups.front().begin() == other.p.begin())
                             for (auto &i : groups)
                                 i.relocate( other.p.begin(), p.begin() );
+                    reindex();
                 }
                 else {
                     for (auto &m : change.groups) {
@@ -282,8 +627,10 @@ namespace Faunus {
                         else // copy only a subset
                             for (auto i : m.atoms)
                                 *(g.begin()+i) = *(gother.begin()+i);
+                        reindex(m);
                     }
                 }
+                updateMirror(change);
                 assert( p.size() == other.p.size() );
                 assert( p.begin() != other.p.begin());
             } //!< Copy differing data from other (o) Space using Change object
@@ -334,6 +681,9 @@ namespace Faunus {
                         }
                     }
                 }
+                if (mirror.enabled)
+                    mirror.update(p);
+
                 double Vold = geo.getVolume();
                 // if isochoric, the volume is constant
                 if (method==Geometry::ISOCHORIC)
@@ -415,6 +765,7 @@ namespace Faunus {
                         }
                         if (begin != spc.p.end())
                             throw std::runtime_error("load error");
+                        spc.reindex();
                     }
                 }
                 // check correctness of molecular mass centers
@@ -466,13 +817,17 @@ namespace Faunus {
                                     }
                                     assert(!p.empty());
                                     spc.push_back(mol->id(), p);
-                                    if (inactive)
+                                    if (inactive) {
                                         spc.groups.back().resize(0);
+                                        spc.reindex(spc.groups.size()-1);
+                                    }
                                 } else {
                                     while ( cnt-- > 0 ) { // insert molecules
                                         spc.push_back(mol->id(), mol->getRandomConformation(spc.geo, spc.p));
-                                        if (inactive)
+                                        if (inactive) {
                                             spc.groups.back().resize(0);
+                                            spc.reindex(spc.groups.size()-1);
+                                        }
                                     }
                                     // load specific positions for the N added molecules
                                     bool success=false;
@@ -531,6 +886,13 @@ namespace Faunus {
         CHECK( spc1.groups.front().id==0);
         CHECK( spc1.groups.front().cm.x()==doctest::Approx(2.5));
 
+        // bounding radius follows `update()`
+        Change c0;
+        c0.groups.resize(1);
+        c0.groups[0].index=0;
+        spc1.update(c0);
+        CHECK( spc1.groups.front().radius==doctest::Approx(0.5));
+
         // check `positions()`
         CHECK( &spc1.positions()[0] == &spc1.p[0].pos );
 
@@ -561,6 +923,43 @@ namespace Faunus {
         spc1.sync(spc2, c);
         CHECK( spc1.p.back().pos.z() == doctest::Approx(-0.1) );
 
+        // structure-of-arrays mirror follows sync
+        CHECK( spc1.mirror.x.empty() ); // disabled by default
+        spc1.mirror.enable(spc1.p);
+        CHECK( spc1.mirror.n==2 );
+        CHECK( spc1.mirror.x.size()==8 ); // padded
+        CHECK( spc1.mirror.x[0]==doctest::Approx(2) );
+        CHECK( reinterpret_cast<std::uintptr_t>(spc1.mirror.z.data()) % 64 == 0 );
+        spc2.p.back().pos.z()=0.5;
+        spc1.sync(spc2, c);
+        CHECK( spc1.mirror.z[1]==doctest::Approx(0.5) );
+        CHECK( spc1.mirror.z[2]==0 ); // padding
+
+        // undo log
+        Change c1;
+        c1.groups.resize(1);
+        c1.groups[0].index=0;
+        c1.groups[0].atoms={1};
+        spc1.backup(0, 1); // disabled --> nothing recorded
+        CHECK( spc1.undolog.empty() );
+        spc1.undolog.enabled=true;
+        double cmz = spc1.groups[0].cm.z();
+        spc1.backup(0, 1);
+        spc1.backup(0, 1); // recorded only once
+        CHECK( spc1.undolog.particles.size()==1 );
+        spc1.p.back().pos.z()=7;
+        spc1.groups[0].cm.z()=7;
+        spc1.undo(c1); // restore
+        CHECK( spc1.p.back().pos.z()==doctest::Approx(0.5) );
+        CHECK( spc1.groups[0].cm.z()==doctest::Approx(cmz) );
+        CHECK( spc1.mirror.z[1]==doctest::Approx(0.5) );
+        spc1.undo(c1); // re-apply
+        CHECK( spc1.p.back().pos.z()==doctest::Approx(7) );
+        CHECK( spc1.groups[0].cm.z()==doctest::Approx(7) );
+        spc1.commit();
+        CHECK( spc1.undolog.empty() );
+        spc1.undolog.enabled=false;
+
         SUBCASE("getActiveParticles") {
             // add three groups to space
             Tspace spc;
@@ -608,7 +1007,162 @@ namespace Faunus {
             }
             CHECK( vals == std::vector<int>({1,2,6,7,8}) );
         }
+
+        SUBCASE("findMolecules") {
+            Tspace spc;
+            spc.geo = R"( {"type": "sphere", "radius": 1e9} )"_json;
+            Tparticle a;
+            a.pos.setZero();
+            typename Tspace::Tpvec pvec({a,a});
+            for (int molid : {0,1,0,0})
+                spc.push_back(molid, pvec);
+            auto all = spc.findMolecules(0, Tspace::ALL);
+            auto active = spc.findMolecules(0, Tspace::ACTIVE);
+            auto inactive = spc.findMolecules(0, Tspace::INACTIVE);
+            auto unknown = spc.findMolecules(2);
+            CHECK( size(all) == 3 );
+            CHECK( size(active) == 3 );
+            CHECK( size(inactive) == 0 );
+            CHECK( size(unknown) == 0 );
+            CHECK( spc.randomMolecule(2, random) == spc.groups.end() );
+
+            spc.groups[2].deactivate(spc.groups[2].begin(), spc.groups[2].end());
+            spc.reindex(2);
+            CHECK( size(active) == 2 ); // views follow the index
+            CHECK( &active[1] == &spc.groups[3] );
+            CHECK( &inactive[0] == &spc.groups[2] );
+            CHECK( spc.randomMolecule(0, random, Tspace::INACTIVE) == spc.groups.begin()+2 );
+
+            Change c; // index follows `sync()`
+            c.all=true;
+            Tspace spc2;
+            spc2.sync(spc, c);
+            auto inactive2 = spc2.findMolecules(0, Tspace::INACTIVE);
+            CHECK( size(inactive2) == 1 );
+            spc2.groups[2].activate(spc2.groups[2].inactive().begin(), spc2.groups[2].inactive().end());
+            c.all=false;
+            c.groups.resize(1);
+            c.groups[0].index=2;
+            spc.sync(spc2, c);
+            CHECK( size(inactive) == 0 );
+            CHECK( size(active) == 3 );
+        }
+
+        SUBCASE("findAtoms") {
+            Tspace spc;
+            spc.geo = R"( {"type": "sphere", "radius": 1e9} )"_json;
+            Tparticle a;
+            a.pos.setZero();
+            a.id=0;
+            typename Tspace::Tpvec pvec({a,a,a,a});
+            pvec[1].id = pvec[3].id = 1;
+            spc.push_back(0, pvec);
+            spc.push_back(0, pvec);
+            auto atoms0 = spc.findAtoms(0);
+            auto atoms1 = spc.findAtoms(1);
+            auto atoms2 = spc.findAtoms(2);
+            CHECK( size(atoms0) == 4 );
+            CHECK( size(atoms1) == 4 );
+            CHECK( size(atoms2) == 0 );
+            CHECK( spc.numAtoms(1) == 4 );
+            CHECK( spc.numMolecules(0) == 2 );
+            CHECK( spc.findGroupContaining(spc.p[5]) == spc.groups.begin()+1 );
+            CHECK( spc.findGroupContaining(a) == spc.groups.end() ); // not in space
+
+            spc.groups[1].deactivate(spc.groups[1].end()-1, spc.groups[1].end()); // last atom, id=1
+            spc.reindexParticle(7);
+            CHECK( size(atoms1) == 3 );
+            CHECK( spc.numAtoms(1) == 3 );
+            CHECK( spc.numMolecules(0, Tspace::INACTIVE) == 1 );
+            CHECK( spc.findGroupContaining(spc.p[7]) == spc.groups.end() ); // inactive
+            auto active = spc.activeParticles();
+            CHECK( std::distance(active.begin(), active.end()) == 7 );
+
+            spc.p[0].id = 1; // type change
+            spc.reindexParticle(0);
+            CHECK( size(atoms0) == 3 );
+            CHECK( size(atoms1) == 4 );
+            for (auto &i : atoms1)
+                CHECK( i.id == 1 );
+
+            Change c; // indices follow `sync()`
+            c.all=true;
+            Tspace spc2;
+            spc2.sync(spc, c);
+            auto atoms1_2 = spc2.findAtoms(1);
+            CHECK( size(atoms1_2) == 4 );
+            spc2.p[2].id = 1;
+            c.all=false;
+            c.groups.resize(1);
+            c.groups[0].index=0;
+            c.groups[0].atoms={2};
+            spc2.reindex(c.groups[0]);
+            CHECK( size(atoms1_2) == 5 );
+            spc.sync(spc2, c);
+            CHECK( size(atoms1) == 5 );
+        }
     }
+
+    /**
+     * @brief Topology and randomly placed ions for unit tests
+     *
+     * Replaces the global topology by monovalent ions, `Na` and `Cl`, in an atomic
+     * `salt` molecule and in a molecular `dimer`, and restores the previous topology
+     * when destroyed. Particles are placed using a private random number generator
+     * so that tests are independent of their order.
+     */
+    template<class Tspace>
+        struct SaltFixture {
+            typedef typename Tspace::Tpvec Tpvec;
+            decltype(atoms) atoms0;                   // topology to restore
+            decltype(molecules<Tpvec>) molecules0;   // topology to restore
+            Random slump;                             // deterministic seed
+            Tspace spc;
+            enum {SALT=0, DIMER=1}; //!< Molecule ids
+
+            SaltFixture(const json &geometry) : atoms0(atoms), molecules0(molecules<Tpvec>) {
+                json j = R"({
+                    "atomlist": [ {"Na": {"q": 1.0, "dp": 2.0}}, {"Cl": {"q": -1.0, "dp": 2.0}} ],
+                    "moleculelist": [
+                        {"salt": {"atoms": ["Na", "Cl"], "atomic": true}},
+                        {"dimer": {"structure": [ {"Na": [0,0,0]}, {"Cl": [1,0,0]} ]}} ] })"_json;
+                atoms = j["atomlist"].get<decltype(atoms)>();
+                molecules<Tpvec> = j["moleculelist"].get<decltype(molecules<Tpvec>)>();
+                spc.geo = geometry;
+            }
+
+            ~SaltFixture() {
+                atoms = atoms0;
+                molecules<Tpvec> = molecules0;
+            }
+
+            Point randompos() {
+                Point a;
+                spc.geo.randompos(a, slump);
+                return a;
+            } //!< Random position in the container
+
+            void addSalt(int N) {
+                Tpvec p(N);
+                for (int i=0; i<N; i++) {
+                    p[i] = atoms[i%2];
+                    p[i].pos = randompos();
+                }
+                spc.push_back(SALT, p);
+            } //!< Add a group of `N` alternating `Na` and `Cl` ions
+
+            void addDimers(int N) {
+                for (int n=0; n<N; n++) {
+                    Tpvec p = molecules<Tpvec>[DIMER].conformations.vec.front();
+                    Point a = randompos();
+                    for (auto &i : p) {
+                        i.pos += a;
+                        spc.geo.boundary(i.pos);
+                    }
+                    spc.push_back(DIMER, p);
+                }
+            } //!< Add `N` randomly placed dimers
+        };
 #endif
 
 }//namespace
@@ -7,6 +7,8 @@
 #include <algorithm>
 #include <cmath>
 #include <memory>
+#include <array>
+#include <stdexcept>
 
 namespace Faunus
 {
@@ -45,6 +47,27 @@ namespace Faunus
                         return (f1(f, x + numdr * 0.5) - f1(f, x - numdr * 0.5)) / (numdr);
                     }
 
+                    /*
+                     * Coefficients of the quintic polynomial in dz=x-xlow that matches
+                     * the value, first, and second derivative at both ends of an
+                     * interval of width `dz1`.
+                     */
+                    static std::array<T,6> quintic( T dz1, T u0low, T u1low, T u2low, T u0upp, T u1upp, T u2upp )
+                    {
+                        T dz2 = dz1 * dz1;
+                        T dz3 = dz2 * dz1;
+                        T c0 = u0low;
+                        T c1 = u1low;
+                        T c2 = u2low * 0.5;
+                        T a = 6 * (u0upp - c0 - c1 * dz1 - c2 * dz2) / dz3;
+                        T b = 2 * (u1upp - c1 - 2 * c2 * dz1) / dz2;
+                        T c = (u2upp - 2 * c2) / dz1;
+                        T c3 = (10 * a - 12 * b + 3 * c) / 6;
+                        T c4 = (-15 * a + 21 * b - 6 * c) / (6 * dz1);
+                        T c5 = (2 * a - 3 * b + c) / (2 * dz2);
+                        return {{c0, c1, c2, c3, c4, c5}};
+                    }
+
                     void check() const
                     {
                         if ( ftol != -1 && ftol <= 0.0 )
@@ -70,7 +93,11 @@ namespace Faunus
                         std::vector<T> r2;  // r2 for intervals
                         std::vector<T> c;   // c for coefficents
                         T rmin2, rmax2;     // useful to save these with table
+                        std::vector<T> segment;  // `Uniform` only: start and inverse spacing of each octave
+                        std::vector<int> offset; // `Uniform` only: first interval of each octave (+ total)
+                        int smin=0;              // `Uniform` only: binary exponent of first octave
                         bool empty() const { return r2.empty() && c.empty(); }
+                        bool uniform() const { return !offset.empty(); } //!< True if generated by `Uniform`
                     };
 
                     void setTolerance( T _utol, T _ftol = -1, T _umaxtol = -1, T _fmaxtol = -1 )
@@ -115,26 +142,8 @@ namespace Faunus
                         if (std::fabs(u1low) < 1e-9 )
                             return {0,0,0,0,0,0,0};
 
-                    T dz1 = zupp - zlow;
-                    T dz2 = dz1 * dz1;
-                    T dz3 = dz2 * dz1;
-                    T w0low = u0low;
-                    T w1low = u1low;
-                    T w2low = u2low;
-                    T w0upp = u0upp;
-                    T w1upp = u1upp;
-                    T w2upp = u2upp;
-                    T c0 = w0low;
-                    T c1 = w1low;
-                    T c2 = w2low * 0.5;
-                    T a = 6 * (w0upp - c0 - c1 * dz1 - c2 * dz2) / dz3;
-                    T b = 2 * (w1upp - c1 - 2 * c2 * dz1) / dz2;
-                    T c = (w2upp - 2 * c2) / dz1;
-                    T c3 = (10 * a - 12 * b + 3 * c) / 6;
-                    T c4 = (-15 * a + 21 * b - 6 * c) / (6 * dz1);
-                    T c5 = (2 * a - 3 * b + c) / (2 * dz2);
-
-                    return {zlow, c0, c1, c2, c3, c4, c5};
+                    auto c = base::quintic(zupp - zlow, u0low, u1low, u2low, u0upp, u1upp, u2upp);
+                    return {zlow, c[0], c[1], c[2], c[3], c[4], c[5]};
                 }
 
                 /**
@@ -319,6 +328,196 @@ namespace Faunus
                 }
         };
 
+        /**
+         * @brief Table with constant time lookup
+         *
+         * The interval is split into octaves, `[2^s:2^(s+1)[`, each with uniformly
+         * spaced knots and the same quintic polynomials as `Andrea`. The number
+         * of knots in each octave is doubled until `utol` (and `ftol`, if given)
+         * is met, so that steep, repulsive parts are resolved without refining
+         * the whole table. The interval containing `x` is found from the binary
+         * exponent of `x` and the octave spacing, i.e. without searching.
+         * `umaxtol` and `fmaxtol` are ignored.
+         */
+        template<typename T=double>
+            class Uniform : public TabulatorBase<T>
+        {
+            private:
+                typedef TabulatorBase<T> base;
+                int maxlevels=24;       // Max number of octaves
+                int maxintervals=1<<14; // Max number of intervals per octave
+
+                bool accurate( const std::array<T,6> &c, std::function<T(T)> f, T xlow, T xupp ) const
+                {
+                    int ncheck = 11; // number of points to control
+                    for ( int i = 0; i < ncheck; i++ )
+                    {
+                        T dz = (xupp - xlow) * i / (ncheck - 1);
+                        T x = xlow + dz;
+                        T usum = c[0] + dz * (c[1] + dz * (c[2] + dz * (c[3] + dz * (c[4] + dz * c[5]))));
+                        if ( std::fabs(usum - f(x)) > base::utol )
+                            return false;
+                        if ( base::ftol != -1 )
+                        {
+                            T fsum = c[1] + dz * (2 * c[2] + dz * (3 * c[3] + dz * (4 * c[4] + dz * 5 * c[5])));
+                            if ( std::fabs(fsum - base::f1(f, x)) > base::ftol )
+                                return false;
+                        }
+                    }
+                    return true;
+                }
+
+            public:
+                /**
+                 * @brief Index of interval containing x
+                 */
+                static inline int index( const typename base::data &d, T x )
+                {
+                    int s = std::max(std::ilogb(x), d.smin) - d.smin; // octave
+                    s = std::min(s, int(d.offset.size()) - 2);
+                    int i = int( (x - d.segment[2 * s]) * d.segment[2 * s + 1] );
+                    return d.offset[s] + std::max(0, std::min(i, d.offset[s + 1] - d.offset[s] - 1));
+                }
+
+                /**
+                 * @brief Get tabulated value at f(x)
+                 * @param d Table data
+                 * @param r2 x value
+                 */
+                inline T eval( const typename base::data &d, T r2 ) const
+                {
+                    size_t pos = index(d, r2);
+                    size_t pos6 = 6 * pos;
+                    T dz = r2 - d.r2[pos];
+                    return d.c[pos6] +
+                        dz * (d.c[pos6 + 1] +
+                                dz * (d.c[pos6 + 2] +
+                                    dz * (d.c[pos6 + 3] +
+                                        dz * (d.c[pos6 + 4] +
+                                            dz * (d.c[pos6 + 5])))));
+                }
+
+                /**
+                 * @brief Get tabulated value at df(x)/dx
+                 * @param d Table data
+                 * @param r2 x value
+                 */
+                T evalDer( const typename base::data &d, T r2 ) const
+                {
+                    size_t pos = index(d, r2);
+                    size_t pos6 = 6 * pos;
+                    T dz = r2 - d.r2[pos];
+                    return (d.c[pos6 + 1] +
+                            dz * (2 * d.c[pos6 + 2] +
+                                dz * (3 * d.c[pos6 + 3] +
+                                    dz * (4 * d.c[pos6 + 4] +
+                                        dz * (5 * d.c[pos6 + 5])))));
+                }
+
+                /**
+                 * @brief Tabulate f(x) in interval [min,max]
+                 */
+                typename base::data generate( std::function<T( T )> f, double rmin, double rmax )
+                {
+                    base::check();
+                    typename base::data td;
+                    td.rmin2 = rmin;
+                    td.rmax2 = rmax;
+
+                    int smax = std::ilogb(rmax);
+                    if ( std::ldexp(T(1), smax) == rmax )
+                        smax--; // rmax is included in the octave below
+                    td.smin = std::max( (rmin > 0) ? std::ilogb(rmin) : smax - maxlevels, smax - maxlevels );
+                    td.smin = std::min( td.smin, smax );
+
+                    for ( int s = td.smin; s <= smax; s++ )
+                    {
+                        T xlow = (s == td.smin) ? rmin : std::ldexp(T(1), s);
+                        T xupp = (s == smax) ? rmax : std::ldexp(T(1), s + 1);
+                        for ( int n = 1; ; n *= 2 )
+                        {
+                            if ( n > maxintervals )
+                                throw std::runtime_error("Uniform spline: try to increase utol/ftol");
+                            T dx = (xupp - xlow) / n;
+                            std::vector<T> knots, coeff;
+                            bool ok = true;
+                            for ( int i = 0; i < n && ok; i++ )
+                            {
+                                T zlow = xlow + i * dx;
+                                T zupp = (i == n - 1) ? xupp : zlow + dx;
+                                auto c = base::quintic(zupp - zlow, f(zlow), base::f1(f, zlow), base::f2(f, zlow),
+                                        f(zupp), base::f1(f, zupp), base::f2(f, zupp));
+                                ok = accurate(c, f, zlow, zupp);
+                                knots.push_back(zlow);
+                                coeff.insert(coeff.end(), c.begin(), c.end());
+                            }
+                            if ( ok )
+                            {
+                                td.segment.push_back(xlow);
+                                td.segment.push_back(1 / dx);
+                                td.offset.push_back(td.r2.size());
+                                td.r2.insert(td.r2.end(), knots.begin(), knots.end());
+                                td.c.insert(td.c.end(), coeff.begin(), coeff.end());
+                                break;
+                            }
+                        }
+                    }
+                    td.offset.push_back(td.r2.size());
+                    td.r2.push_back(rmax);
+                    return td;
+                }
+        };
+
+        /**
+         * @brief Tabulator selected at runtime
+         *
+         * Forwards to `Andrea` (`andrea`, default) or `Uniform` (`uniform`).
+         */
+        template<typename T=double>
+            class Tabulator
+        {
+            private:
+                Andrea<T> andrea;
+                Uniform<T> uniform;
+                bool isuniform=false;
+
+            public:
+                typedef typename TabulatorBase<T>::data data;
+
+                void setTolerance( T utol, T ftol = -1, T umaxtol = -1, T fmaxtol = -1 )
+                {
+                    andrea.setTolerance(utol, ftol, umaxtol, fmaxtol);
+                    uniform.setTolerance(utol, ftol, umaxtol, fmaxtol);
+                }
+
+                void setMethod( const std::string &method )
+                {
+                    if ( method == "andrea" )
+                        isuniform = false;
+                    else if ( method == "uniform" )
+                        isuniform = true;
+                    else
+                        throw std::runtime_error("unknown tabulator '" + method + "'");
+                }
+
+                std::string method() const { return isuniform ? "uniform" : "andrea"; }
+
+                data generate( std::function<T( T )> f, double rmin, double rmax )
+                {
+                    return isuniform ? uniform.generate(f, rmin, rmax) : andrea.generate(f, rmin, rmax);
+                }
+
+                inline T eval( const data &d, T r2 ) const
+                {
+                    return isuniform ? uniform.eval(d, r2) : andrea.eval(d, r2);
+                }
+
+                inline T evalDer( const data &d, T r2 ) const
+                {
+                    return isuniform ? uniform.evalDer(d, r2) : andrea.evalDer(d, r2);
+                }
+        };
+
 #ifdef DOCTEST_LIBRARY_INCLUDED
         TEST_CASE("[Faunus] Andrea")
         {
@@ -334,6 +533,34 @@ namespace Faunus
             CHECK( spline.eval(d,10) == Approx(f(10)) );
             CHECK( spline.eval(d,10+1e-9) != Approx(10+1e-9));
         }
+
+        TEST_CASE("[Faunus] Uniform")
+        {
+            using doctest::Approx;
+
+            auto f = [](double x){return 0.5*x*std::sin(x)+2;};
+            Uniform<double> spline;
+            spline.setTolerance(2e-4, 1e-2);
+            auto d = spline.generate(f, 0, 10);
+
+            CHECK( d.uniform() );
+            CHECK( spline.eval(d,1e-9) == Approx(f(1e-9)) );
+            CHECK( spline.eval(d,5) == Approx(f(5)) );
+            CHECK( spline.eval(d,10) == Approx(f(10)) );
+            for (double x : {1e-3, 0.3, 1.0, 2.0, 3.7, 8.0, 9.99})
+                CHECK( std::fabs(spline.eval(d,x) - f(x)) < 2e-4 );
+
+            auto g = [](double r2){return std::pow(r2,-6) - std::pow(r2,-3);}; // LJ in r^2
+            auto e = spline.generate(g, 0.8, 9);
+            for (double x=0.8; x<9; x+=0.01) // utol is enforced at control points only
+                CHECK( std::fabs(spline.eval(e,x) - g(x)) < 4e-4 );
+
+            Tabulator<double> t;
+            CHECK( t.method() == "andrea" );
+            t.setMethod("uniform");
+            CHECK( t.generate(f, 0, 10).uniform() );
+            CHECK_THROWS( t.setMethod("unknown") );
+        }
 #endif
 
     } //Tabulate namespace
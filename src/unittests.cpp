@@ -17,4 +17,5 @@
 #include "move.h"
 #include "penalty.h"
 #include "celllist.h"
+#include "simd.h"
 